@@ -5,3 +5,16 @@ OTHER_FILES += \
     rpm/nemo-qml-plugin-dbus-qt5.spec
 
 tests.depends = src
+
+demarshall.subdir = tests/demarshall
+demarshall.depends = src
+SUBDIRS += demarshall
+
+# Compile check of the C++20 coroutine header, where Qt was built with a compiler supporting it.
+greaterThan(QT_MAJOR_VERSION, 5)|greaterThan(QT_MINOR_VERSION, 11) {
+    qtConfig(c++2a)|qtConfig(c++20) {
+        coroutine.subdir = tests/coroutine
+        coroutine.depends = src
+        SUBDIRS += coroutine
+    }
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "batch.h"
+#include "connectiondata.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+
+namespace NemoDBus {
+
+Batch::Batch(ConnectionData *connection, const QLoggingCategory &logs, QObject *parent)
+    : QObject(parent)
+    , m_connection(connection)
+    , m_logs(logs)
+    , m_maximumPendingCalls(0)
+    , m_nextCall(0)
+    , m_answeredCalls(0)
+    , m_started(false)
+    , m_finished(false)
+{
+}
+
+Batch::~Batch()
+{
+    // As for responses, delete the watchers and their queued events before the reference to
+    // the connection is released.
+    qDeleteAll(m_watchers.keys());
+    QCoreApplication::removePostedEvents(this);
+}
+
+int Batch::maximumPendingCalls() const
+{
+    return m_maximumPendingCalls;
+}
+
+void Batch::setMaximumPendingCalls(int maximum)
+{
+    m_maximumPendingCalls = qMax(0, maximum);
+
+    if (m_started) {
+        dispatch();
+    }
+}
+
+int Batch::count() const
+{
+    return m_messages.count();
+}
+
+bool Batch::isFinished() const
+{
+    return m_finished;
+}
+
+bool Batch::hasErrors() const
+{
+    for (const QDBusMessage &message : m_messages) {
+        if (message.type() == QDBusMessage::ErrorMessage) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QDBusMessage Batch::reply(int index) const
+{
+    const QDBusMessage message = m_messages.value(index);
+    return message.type() != QDBusMessage::MethodCallMessage ? message : QDBusMessage();
+}
+
+QVariantList Batch::arguments(int index) const
+{
+    const QDBusMessage message = m_messages.value(index);
+    return message.type() == QDBusMessage::ReplyMessage ? message.arguments() : QVariantList();
+}
+
+QDBusError Batch::error(int index) const
+{
+    const QDBusMessage message = m_messages.value(index);
+    return message.type() == QDBusMessage::ErrorMessage ? QDBusError(message) : QDBusError();
+}
+
+void Batch::start()
+{
+    if (!m_started) {
+        m_started = true;
+
+        dispatch();
+    }
+}
+
+int Batch::enqueue(const QDBusMessage &message)
+{
+    if (m_finished) {
+        qCWarning(logs(), "DBus invocation (%s %s %s.%s) added to a finished batch",
+                  qPrintable(message.service()),
+                  qPrintable(message.path()),
+                  qPrintable(message.interface()),
+                  qPrintable(message.member()));
+        return -1;
+    }
+
+    m_messages.append(message);
+
+    if (m_started) {
+        dispatch();
+    }
+
+    return m_messages.count() - 1;
+}
+
+void Batch::dispatch()
+{
+    const QDBusConnection connection = m_connection->connection;
+
+    while (m_nextCall < m_messages.count()
+           && (m_maximumPendingCalls == 0
+               || m_nextCall - m_answeredCalls < m_maximumPendingCalls)) {
+        const QDBusMessage &message = m_messages.at(m_nextCall);
+
+        qCDebug(logs(), "DBus invocation (%s %s %s.%s)",
+                qPrintable(message.service()),
+                qPrintable(message.path()),
+                qPrintable(message.interface()),
+                qPrintable(message.member()));
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                    connection.asyncCall(message), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, &Batch::callFinished);
+
+        m_watchers.insert(watcher, m_nextCall);
+        ++m_nextCall;
+    }
+
+    if (m_answeredCalls == m_messages.count() && !m_finished) {
+        m_finished = true;
+        deleteLater();
+
+        emit finished();
+    }
+}
+
+void Batch::callFinished(QDBusPendingCallWatcher *watcher)
+{
+    const int index = m_watchers.take(watcher);
+    watcher->deleteLater();
+
+    const QDBusMessage reply = watcher->reply();
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        const QDBusMessage &message = m_messages.at(index);
+        qCWarning(logs(), "DBus error (%s %s %s.%s): %s %s",
+                  qPrintable(message.service()),
+                  qPrintable(message.path()),
+                  qPrintable(message.interface()),
+                  qPrintable(message.member()),
+                  qPrintable(reply.errorName()),
+                  qPrintable(reply.errorMessage()));
+    }
+
+    m_messages[index] = reply;
+    ++m_answeredCalls;
+
+    dispatch();
+}
+
+}
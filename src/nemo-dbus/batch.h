@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef NEMODBUS_BATCH_H
+#define NEMODBUS_BATCH_H
+
+#include <nemo-dbus/dbus.h>
+
+#include <QDBusError>
+#include <QDBusPendingCallWatcher>
+#include <QExplicitlySharedDataPointer>
+#include <QHash>
+#include <QVector>
+
+namespace NemoDBus {
+
+class ConnectionData;
+
+// Queues method calls which are sent back to back, once control returns to the event loop, and
+// reports once when all of them have been answered. The replies are kept in the order the calls
+// were made, the batch deletes itself after the finished handlers have been invoked.
+class NEMODBUS_EXPORT Batch : public QObject
+{
+    Q_OBJECT
+public:
+    ~Batch();
+
+    // Queues a call and returns its index in the batch.
+    template <typename... Arguments>
+    int call(
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method,
+            Arguments &&...arguments)
+    {
+        QDBusMessage message = QDBusMessage::createMethodCall(service, path, interface, method);
+        appendArguments(message, std::forward<Arguments>(arguments)...);
+        return enqueue(message);
+    }
+
+    // The number of calls waiting for a reply at a time, calls over the limit are sent as
+    // earlier ones are answered. Zero, the default, sends all calls at once.
+    int maximumPendingCalls() const;
+    void setMaximumPendingCalls(int maximum);
+
+    int count() const;
+    bool isFinished() const;
+    bool hasErrors() const;
+
+    QDBusMessage reply(int index) const;
+    QVariantList arguments(int index) const;
+    QDBusError error(int index) const;
+
+    template <typename T> T argument(int index, int argument = 0) const
+    {
+        return demarshallArgument<T>(arguments(index).value(argument));
+    }
+
+    template <typename Handler> void onFinished(const Handler &handler)
+    {
+        connect(this, &Batch::finished, [this, handler]() {
+            handler(*this);
+        });
+    }
+
+public slots:
+    void start();
+
+signals:
+    void finished();
+
+private slots:
+    void callFinished(QDBusPendingCallWatcher *watcher);
+
+private:
+    friend class ConnectionData;
+
+    Batch(ConnectionData *connection, const QLoggingCategory &logs, QObject *parent);
+
+    int enqueue(const QDBusMessage &message);
+    void dispatch();
+
+    const QLoggingCategory &logs()
+    {
+        return m_logs;
+    }
+
+    QExplicitlySharedDataPointer<ConnectionData> m_connection;
+    const QLoggingCategory &m_logs;
+    // Each call message is replaced by its reply once that is received.
+    QVector<QDBusMessage> m_messages;
+    QHash<QDBusPendingCallWatcher *, int> m_watchers;
+    int m_maximumPendingCalls;
+    int m_nextCall;
+    int m_answeredCalls;
+    bool m_started;
+    bool m_finished;
+};
+
+}
+
+#endif
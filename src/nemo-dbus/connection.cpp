@@ -30,18 +30,33 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
  */
 
+#include "batch.h"
 #include "connection.h"
 #include "connectiondata.h"
 
 #include "logging.h"
 
-typedef QExplicitlySharedDataPointer<NemoDBus::ConnectionData> ConnectionDataPointer;
-Q_DECLARE_METATYPE(ConnectionDataPointer)
+#include <QTimer>
 
 namespace NemoDBus {
 
+// A negative timeout selects the QtDBus default of 25 seconds.
+static int callTimeout(const Deadline &deadline)
+{
+    return deadline.isForever() ? -1 : qMax(1, deadline.remainingTime());
+}
+
+// Whether a call with the deadline can share a pending call with the other deadline, without
+// the shared call timing out before the deadline has passed.
+static bool endsNoLaterThan(const Deadline &deadline, const Deadline &other)
+{
+    return other.isForever()
+            || (!deadline.isForever() && deadline.remainingTime() <= other.remainingTime());
+}
+
 ConnectionData::ConnectionData(const QDBusConnection &connection, const QLoggingCategory &logs)
     : connection(connection)
+    , replyCache(connection)
     , m_logs(logs)
 {
     if (connection.isConnected()) {
@@ -69,7 +84,7 @@ bool ConnectionData::getProperty(
 {
     auto message = QDBusMessage::createMethodCall(
                 service, path, QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Get"));
-    message.setArguments(marshallArguments(interface, property));
+    appendArguments(message, interface, property);
 
     const auto reply = connection.call(message);
 
@@ -104,6 +119,7 @@ void ConnectionData::handleDisconnect()
     qCDebug(logs(), "Disconnected from %s", qPrintable(connection.name()));
 
     deletePropertyListeners();
+    replyCache.clear();
 
     emit disconnected();
 }
@@ -126,28 +142,172 @@ Response *ConnectionData::callMethod(
         const QString &method,
         const QVariantList &arguments)
 {
-    qCDebug(logs(), "DBus invocation (%s %s %s.%s)",
-            qPrintable(service), qPrintable(path), qPrintable(interface), qPrintable(method));
-
     QDBusMessage message = QDBusMessage::createMethodCall(service, path, interface, method);
     message.setArguments(arguments);
 
+    return callMethod(context, message, Deadline::current());
+}
+
+Response *ConnectionData::callMethod(
+        QObject *context, const QDBusMessage &message, const Deadline &deadline)
+{
+    if (deadline.hasExpired()) {
+        return expiredCallMethod(context, message, deadline);
+    } else if (replyCache.timeout(message) > 0) {
+        return cachedCallMethod(context, message, deadline);
+    }
+
+    qCDebug(logs(), "DBus invocation (%s %s %s.%s)",
+            qPrintable(message.service()),
+            qPrintable(message.path()),
+            qPrintable(message.interface()),
+            qPrintable(message.member()));
+
+    const auto response = createResponse(context, deadline);
+    response->watch(connection.asyncCall(message, callTimeout(deadline)));
+
+    return response;
+}
+
+Response *ConnectionData::createResponse(QObject *context, const Deadline &deadline)
+{
     const auto response = new Response(m_logs, context);
-    // Setting the connection as a dynamic property of the response will keep a reference to it
-    // alive until after the the response's QObject destructor has executed.  This is important
-    // because the object may have a queued QDBusCallDeliveryEvent containing a reference to the
-    // connection which could be stale if all other references to the connection are freed before
-    // the response is destroyed.
-    response->setProperty("connection", QVariant::fromValue(ConnectionDataPointer(this)));
-    connection.callWithCallback(
-                message,
-                response,
-                SLOT(callReturn(QDBusMessage)),
-                SLOT(callError(QDBusError,QDBusMessage)));
+    response->m_connection = this;
+    response->m_deadline = deadline;
+
+    return response;
+}
+
+Response *ConnectionData::expiredCallMethod(
+        QObject *context, const QDBusMessage &message, const Deadline &deadline)
+{
+    const auto response = createResponse(context, deadline);
+    // The same error QtDBus reports for a call whose deadline passes while it is pending.
+    const QDBusError error(
+                QDBusError::NoReply, QStringLiteral("The deadline passed before the call was made"));
+
+    QTimer::singleShot(0, response, [response, error, message]() {
+        response->callError(error, message);
+    });
+
+    return response;
+}
+
+Response *ConnectionData::cachedCallMethod(
+        QObject *context, const QDBusMessage &message, const Deadline &deadline)
+{
+    QDBusMessage reply;
+    if (!replyCache.find(message, &reply)) {
+        return coalescedCallMethod(context, message, deadline);
+    }
+
+    qCDebug(logs(), "DBus invocation (%s %s %s.%s) answered from the reply cache",
+            qPrintable(message.service()),
+            qPrintable(message.path()),
+            qPrintable(message.interface()),
+            qPrintable(message.member()));
+
+    const auto response = createResponse(context, deadline);
+
+    // The reply is delivered from the event loop so handlers can be connected after the call
+    // returns, as with any other response.
+    QTimer::singleShot(0, response, [response, reply]() {
+        response->callReturn(reply);
+    });
+
+    return response;
+}
+
+Response *ConnectionData::coalescedCallMethod(
+        QObject *context, const QDBusMessage &message, const Deadline &deadline)
+{
+    if (deadline.hasExpired()) {
+        return expiredCallMethod(context, message, deadline);
+    }
+
+    const auto response = createResponse(context, deadline);
+
+    for (CoalescedCall &call : m_coalescedCalls) {
+        // A call with a later deadline than the pending one is made again rather than failing
+        // when the pending call times out.
+        if (endsNoLaterThan(deadline, call.deadline) && equalCalls(call.message, message)) {
+            qCDebug(logs(), "DBus invocation (%s %s %s.%s) joined a pending identical call",
+                    qPrintable(message.service()),
+                    qPrintable(message.path()),
+                    qPrintable(message.interface()),
+                    qPrintable(message.member()));
+
+            call.responses.append(response);
+
+            // The pending call may outlast an earlier deadline of this one.
+            if (!deadline.isForever()) {
+                QTimer::singleShot(callTimeout(deadline), response, [response, message]() {
+                    response->callError(QDBusError(
+                                QDBusError::NoReply,
+                                QStringLiteral("The deadline passed before a reply was received")),
+                                message);
+                });
+            }
+
+            return response;
+        }
+    }
+
+    qCDebug(logs(), "DBus invocation (%s %s %s.%s)",
+            qPrintable(message.service()),
+            qPrintable(message.path()),
+            qPrintable(message.interface()),
+            qPrintable(message.member()));
+
+    CoalescedCall call;
+    call.message = message;
+    call.watcher = new QDBusPendingCallWatcher(connection.asyncCall(message, callTimeout(deadline)), this);
+    call.responses.append(response);
+    call.deadline = deadline;
+    call.cacheGeneration = replyCache.generation();
+
+    connect(call.watcher, &QDBusPendingCallWatcher::finished,
+            this, &ConnectionData::coalescedCallFinished);
+
+    m_coalescedCalls.append(call);
 
     return response;
 }
 
+void ConnectionData::coalescedCallFinished(QDBusPendingCallWatcher *watcher)
+{
+    watcher->deleteLater();
+
+    const QDBusMessage reply = watcher->reply();
+
+    QVector<QPointer<Response>> responses;
+    for (int i = 0; i < m_coalescedCalls.count(); ++i) {
+        if (m_coalescedCalls.at(i).watcher == watcher) {
+            const CoalescedCall call = m_coalescedCalls.takeAt(i);
+
+            replyCache.insert(call.message, reply, call.cacheGeneration);
+            responses = call.responses;
+            break;
+        }
+    }
+
+    for (const QPointer<Response> &response : responses) {
+        // The context of a response may have been destroyed while the call was pending.
+        if (response) {
+            response->callFinished(reply);
+        }
+    }
+}
+
+Batch *ConnectionData::batch(QObject *context)
+{
+    const auto batch = new Batch(this, m_logs, context);
+    // Calls queued before control returns to the event loop are all sent in the same pass.
+    QMetaObject::invokeMethod(batch, "start", Qt::QueuedConnection);
+
+    return batch;
+}
+
 QDBusMessage ConnectionData::blockingCallMethod(
         const QString &service,
         const QString &path,
@@ -155,12 +315,20 @@ QDBusMessage ConnectionData::blockingCallMethod(
         const QString &method,
         const QVariantList &arguments)
 {
-    qCDebug(logs(), "DBus invocation (%s %s %s.%s)",
-            qPrintable(service), qPrintable(path), qPrintable(interface), qPrintable(method));
-
     QDBusMessage message = QDBusMessage::createMethodCall(service, path, interface, method);
     message.setArguments(arguments);
 
+    return blockingCallMethod(message);
+}
+
+QDBusMessage ConnectionData::blockingCallMethod(const QDBusMessage &message)
+{
+    qCDebug(logs(), "DBus invocation (%s %s %s.%s)",
+            qPrintable(message.service()),
+            qPrintable(message.path()),
+            qPrintable(message.interface()),
+            qPrintable(message.member()));
+
     return connection.call(message);
 }
 
@@ -216,6 +384,7 @@ bool Connection::isConnected() const
 bool Connection::reconnect(const QDBusConnection &connection)
 {
     d->connection = connection;
+    d->replyCache.setConnection(connection);
 
     if (d->connection.isConnected()) {
         qCDebug(d->logs(), "Connected to %s", qPrintable(d->connection.name()));
@@ -231,6 +400,28 @@ bool Connection::reconnect(const QDBusConnection &connection)
     }
 }
 
+void Connection::cacheReplies(
+        const QString &service,
+        const QString &path,
+        const QString &interface,
+        const QString &method,
+        int timeout,
+        const QStringList &invalidatingSignals)
+{
+    d->replyCache.setTimeout(service, path, interface, method, timeout, invalidatingSignals);
+}
+
+void Connection::invalidateCachedReplies(
+        const QString &service, const QString &path, const QString &interface, const QString &method)
+{
+    d->replyCache.invalidate(service, path, interface, method);
+}
+
+Batch *Connection::batch(QObject *context)
+{
+    return d->batch(context);
+}
+
 bool Connection::connectToSignal(
         const QString &service,
         const QString &path,
@@ -33,6 +33,7 @@
 #ifndef NEMODBUS_CONNECTION_H
 #define NEMODBUS_CONNECTION_H
 
+#include <nemo-dbus/batch.h>
 #include <nemo-dbus/dbus.h>
 #include <nemo-dbus/response.h>
 #include <nemo-dbus/private/connectiondata.h>
@@ -84,6 +85,40 @@ public:
                 std::forward<Arguments>(arguments)...);
     }
 
+    // As call(), but the call fails with a QDBusError::NoReply error if no reply is received
+    // before the deadline.  Calls made without a deadline use the deadline of the response whose handler
+    // makes them, if any.
+    template <typename... Arguments>
+    Response *call(
+            QObject *context,
+            const Deadline &deadline,
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method,
+            Arguments &&...arguments)
+    {
+        return d->call(context, deadline, service, path, interface, method,
+                std::forward<Arguments>(arguments)...);
+    }
+
+    // As call(), but while a call with the same method and arguments is pending no new call is
+    // made and the returned response finishes with the reply to the pending call.  This should
+    // only be used for methods which have no side effects.  Each response keeps its own deadline,
+    // a call whose deadline is later than that of the pending call is made anew.
+    template <typename... Arguments>
+    Response *coalescedCall(
+            QObject *context,
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method,
+            Arguments &&...arguments)
+    {
+        return d->coalescedCall(context, service, path, interface, method,
+                std::forward<Arguments>(arguments)...);
+    }
+
     template <typename... Arguments>
     QDBusMessage blockingCall(
             const QString &service,
@@ -96,6 +131,28 @@ public:
                 std::forward<Arguments>(arguments)...);
     }
 
+    // Answers repeated calls to a method without side effects from a cache of replies for up to
+    // timeout milliseconds, or until one of the invalidating signals is received.  Signals on
+    // other interfaces are given with their interface name, e.g.
+    // org.freedesktop.DBus.Properties.PropertiesChanged.  Calls to a cached method which miss
+    // the cache are coalesced as with coalescedCall(), so identical calls made while one is
+    // pending share its reply.
+    void cacheReplies(
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method,
+            int timeout,
+            const QStringList &invalidatingSignals = QStringList());
+    void invalidateCachedReplies(
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method = QString());
+
+    // Returns a batch which sends the calls queued on it when control returns to the event loop.
+    Batch *batch(QObject *context);
+
     template <typename T, typename Handler>
     void subscribeToProperty(
             QObject *context,
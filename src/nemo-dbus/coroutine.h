@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef NEMODBUS_COROUTINE_H
+#define NEMODBUS_COROUTINE_H
+
+#include <nemo-dbus/response.h>
+
+// Awaiting replies requires C++20 coroutines, the header is empty when they are not enabled.
+#if defined(__cpp_impl_coroutine)
+
+#include <QDBusError>
+
+#include <coroutine>
+#include <exception>
+#include <tuple>
+
+namespace NemoDBus {
+
+// Thrown from co_await when a call fails.
+class CallError : public std::exception
+{
+public:
+    explicit CallError(const QDBusError &error)
+        : m_error(error)
+        , m_what(error.name().toUtf8() + ": " + error.message().toUtf8())
+    {
+    }
+
+    const QDBusError &error() const noexcept
+    {
+        return m_error;
+    }
+
+    const char *what() const noexcept override
+    {
+        return m_what.constData();
+    }
+
+private:
+    QDBusError m_error;
+    QByteArray m_what;
+};
+
+// The result of awaiting a reply: nothing, a single value, or a tuple of several values.
+template <typename... Arguments> struct ReplyValue
+{
+    typedef std::tuple<Arguments...> type;
+
+    static type take(const QVariantList &arguments)
+    {
+        return take(arguments, typename MakeArgumentIndexes<sizeof...(Arguments)>::type());
+    }
+
+    template <std::size_t... Indexes>
+    static type take(const QVariantList &arguments, ArgumentIndexes<Indexes...>)
+    {
+        return type(demarshallArgument<Arguments>(arguments.value(Indexes))...);
+    }
+};
+
+template <typename Argument> struct ReplyValue<Argument>
+{
+    typedef Argument type;
+
+    static type take(const QVariantList &arguments)
+    {
+        return demarshallArgument<Argument>(arguments.value(0));
+    }
+};
+
+template <> struct ReplyValue<>
+{
+    typedef void type;
+
+    static void take(const QVariantList &) {}
+};
+
+// Suspends a coroutine until a response finishes.  The coroutine is resumed from the response's
+// handlers, so on the thread of the context object the call was made with.
+template <typename... Arguments> class ReplyAwaiter
+{
+public:
+    explicit ReplyAwaiter(Response *response)
+        : m_response(response)
+    {
+    }
+
+    ReplyAwaiter(const ReplyAwaiter &) = delete;
+    ReplyAwaiter &operator =(const ReplyAwaiter &) = delete;
+
+    ~ReplyAwaiter()
+    {
+        disconnect();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coroutine)
+    {
+        m_success = QObject::connect(
+                    m_response, &Response::success, [this, coroutine](const QVariantList &arguments) {
+            m_arguments = arguments;
+            resume(coroutine);
+        });
+        m_failure = QObject::connect(
+                    m_response, &Response::failure, [this, coroutine](const QDBusError &error) {
+            m_error = error;
+            resume(coroutine);
+        });
+        m_destroyed = QObject::connect(m_response, &QObject::destroyed, [this, coroutine]() {
+            m_error = QDBusError(
+                        QDBusError::NoReply,
+                        QStringLiteral("The response was destroyed before a reply was received"));
+            resume(coroutine);
+        });
+    }
+
+    typename ReplyValue<Arguments...>::type await_resume()
+    {
+        if (m_error.isValid()) {
+            throw CallError(m_error);
+        }
+        return ReplyValue<Arguments...>::take(m_arguments);
+    }
+
+private:
+    void disconnect()
+    {
+        QObject::disconnect(m_success);
+        QObject::disconnect(m_failure);
+        QObject::disconnect(m_destroyed);
+    }
+
+    void resume(std::coroutine_handle<> coroutine)
+    {
+        disconnect();
+        coroutine.resume();
+    }
+
+    Response * const m_response;
+    QMetaObject::Connection m_success;
+    QMetaObject::Connection m_failure;
+    QMetaObject::Connection m_destroyed;
+    QVariantList m_arguments;
+    QDBusError m_error;
+};
+
+// Awaits the reply to a call, demarshalled as the given argument types.
+//
+//     const QString profile = co_await NemoDBus::reply<QString>(
+//                 m_profiled.call(QStringLiteral("get_profile")));
+//
+// A failed call throws a CallError, as does a response which is destroyed along with its
+// context object before a reply is received.
+template <typename... Arguments> ReplyAwaiter<Arguments...> reply(Response *response)
+{
+    return ReplyAwaiter<Arguments...>(response);
+}
+
+// A coroutine which starts immediately and cleans up after itself when it completes, for
+// sequences of dependent calls which don't return a result to a caller.
+class Task
+{
+public:
+    struct promise_type
+    {
+        Task get_return_object() noexcept
+        {
+            return Task();
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        void unhandled_exception() noexcept
+        {
+            try {
+                throw;
+            } catch (const CallError &error) {
+                qWarning("Unhandled DBus error in a coroutine: %s", error.what());
+            } catch (...) {
+                std::terminate();
+            }
+        }
+    };
+};
+
+}
+
+#endif
+
+#endif
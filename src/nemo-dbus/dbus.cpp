@@ -32,6 +32,8 @@
 
 #include "dbus.h"
 #include "connection.h"
+#include "signatureplan.h"
+#include "stringpool.h"
 
 #include <QThreadStorage>
 #include <QDBusMetaType>
@@ -73,6 +75,11 @@ Connection sessionBus()
 }
 
 QVariant demarshallDBusArgument(const QVariant &val, int depth)
+{
+    return demarshallDBusArgument(val, DefaultDemarshalling, depth);
+}
+
+QVariant demarshallDBusArgument(const QVariant &val, DemarshallOptions options, int depth)
 {
     // Make sure that dbus types are registered.
     registerDBusTypes();
@@ -89,10 +96,15 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
     QVariant res;
 
     const int type = val.userType();
+    QSharedPointer<const SignaturePlan> plan;
 
     if (++depth > maximum_dept) {
         /* Leave result to invalid variant */
         qWarning() << "Too deep recursion detected at userType:" << type;
+    } else if (type == QVariant::ByteArray && (options & KeepByteArrays)) {
+        /* Is converted to an ArrayBuffer sharing the same data in
+         * the qml domain, use as is if the receiver can handle it */
+        res = val;
     } else if (type == QVariant::ByteArray) {
         /* Is built-in type, but does not get correctly converted
          * to qml domain -> convert to variant list */
@@ -110,7 +122,7 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
         res = val;
     } else if (type == qMetaTypeId<QDBusVariant>()) {
         /* Convert QDBusVariant to QVariant */
-        res = demarshallDBusArgument(val.value<QDBusVariant>().variant(), depth);
+        res = demarshallDBusArgument(val.value<QDBusVariant>().variant(), options, depth);
     } else if (type == qMetaTypeId<QDBusObjectPath>()) {
         /* Convert QDBusObjectPath to QString */
         res = val.value<QDBusObjectPath>().path();
@@ -120,6 +132,12 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
     } else if (type == qMetaTypeId<QDBusUnixFileDescriptor>()) {
         /* Ignore, leave it to the receiver to extract the file descriptor */
         res = val;
+    } else if (type == qMetaTypeId<QDBusArgument>()
+               && (plan = SignaturePlan::fromArgument(val.value<QDBusArgument>()))) {
+        /* The same few signatures are received over and over again, run
+         * the conversion plan compiled for this one instead of probing
+         * the type of every element */
+        res = plan->demarshall(val.value<QDBusArgument>(), options, depth);
     } else if (type == qMetaTypeId<QDBusArgument>()) {
         /* Try to deal with everything QDBusArgument could be ... */
         const QDBusArgument &arg = val.value<QDBusArgument>();
@@ -128,13 +146,13 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
         case QDBusArgument::BasicType:
             /* Most of the basic types should be convertible to QVariant.
              * Recurse anyway to deal with object paths and the like. */
-            res = demarshallDBusArgument(arg.asVariant(), depth);
+            res = demarshallDBusArgument(arg.asVariant(), options, depth);
             break;
 
         case QDBusArgument::VariantType:
             /* Try to convert to QVariant. Recurse to check content */
             res = demarshallDBusArgument(arg.asVariant().value<QDBusVariant>().variant(),
-                                         depth);
+                                         options, depth);
             break;
 
         case QDBusArgument::ArrayType:
@@ -144,7 +162,7 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
                 arg.beginArray();
                 while (!arg.atEnd()) {
                     QVariant tmp = arg.asVariant();
-                    list.append(demarshallDBusArgument(tmp, depth));
+                    list.append(demarshallDBusArgument(tmp, options, depth));
                 }
                 arg.endArray();
                 res = list;
@@ -158,7 +176,7 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
                 arg.beginStructure();
                 while (!arg.atEnd()) {
                     QVariant tmp = arg.asVariant();
-                    list.append(demarshallDBusArgument(tmp, depth));
+                    list.append(demarshallDBusArgument(tmp, options, depth));
                 }
                 arg.endStructure();
                 res = QVariant::fromValue(list);
@@ -174,8 +192,10 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
                     arg.beginMapEntry();
                     QVariant key = arg.asVariant();
                     QVariant val = arg.asVariant();
-                    map.insert(demarshallDBusArgument(key, depth).toString(),
-                               demarshallDBusArgument(val, depth));
+                    QString name = demarshallDBusArgument(key, options, depth).toString();
+                    if (key.userType() == QMetaType::QString)
+                        name = internString(name);
+                    map.insert(name, demarshallDBusArgument(val, options, depth));
                     arg.endMapEntry();
                 }
                 arg.endMap();
@@ -198,26 +218,30 @@ QVariant demarshallDBusArgument(const QVariant &val, int depth)
     return res;
 }
 
-void registerDBusTypes()
+static bool registerTypes()
 {
-    static bool done = false;
+    qDBusRegisterMetaType< QList<bool> >();
+    qDBusRegisterMetaType< QList<int> >();
+    qDBusRegisterMetaType< QList<double> >();
 
-    if (!done) {
-        done = true;
+    qDBusRegisterMetaType< QList<quint8> >();
+    qDBusRegisterMetaType< QList<quint16> >();
+    qDBusRegisterMetaType< QList<quint32> >();
+    qDBusRegisterMetaType< QList<quint64> >();
 
-        qDBusRegisterMetaType< QList<bool> >();
-        qDBusRegisterMetaType< QList<int> >();
-        qDBusRegisterMetaType< QList<double> >();
+    qDBusRegisterMetaType< QList<qint16> >();
+    qDBusRegisterMetaType< QList<qint32> >();
+    qDBusRegisterMetaType< QList<qint64> >();
 
-        qDBusRegisterMetaType< QList<quint8> >();
-        qDBusRegisterMetaType< QList<quint16> >();
-        qDBusRegisterMetaType< QList<quint32> >();
-        qDBusRegisterMetaType< QList<quint64> >();
+    return true;
+}
 
-        qDBusRegisterMetaType< QList<qint16> >();
-        qDBusRegisterMetaType< QList<qint32> >();
-        qDBusRegisterMetaType< QList<qint64> >();
-    }
+void registerDBusTypes()
+{
+    /* Arguments can be demarshalled from several threads, the
+     * initialization of a static local is done exactly once */
+    static const bool registered = registerTypes();
+    Q_UNUSED(registered);
 }
 
 }
@@ -38,13 +38,31 @@
 #include <QDBusArgument>
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusMetaType>
 #include <QDBusVariant>
+#include <QHash>
+#include <QMap>
 #include <QVector>
 
+#include <tuple>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <optional>
+#include <variant>
+#endif
+
 namespace NemoDBus {
 
 class Connection;
 
+enum DemarshallOption {
+    DefaultDemarshalling = 0x00,
+    KeepByteArrays = 0x01,
+    PackNumericArrays = 0x02
+};
+Q_DECLARE_FLAGS(DemarshallOptions, DemarshallOption)
+
 template <typename Argument> inline QVariant marshallArgument(const Argument &argument)
 {
     return QVariant::fromValue(argument);
@@ -55,25 +73,264 @@ inline QVariant marshallArgument(const QVariant &argument)
     return QVariant::fromValue(QDBusVariant(argument));
 }
 
-template <typename Argument> inline Argument demarshallArgument(const QVariant &argument)
+// Demarshalls an argument of a given type. Containers are specialized to stream their elements
+// straight out of a QDBusArgument, which also allows elements of types which QtDBus has no
+// operators for, such as std::vector or std::tuple.
+template <typename Argument> struct ArgumentDemarshaller
 {
-    if (argument.userType() == qMetaTypeId<QDBusArgument>()) {
+    static Argument demarshall(const QDBusArgument &argument)
+    {
         Argument demarshalled;
-        argument.value<QDBusArgument>() >> demarshalled;
+        argument >> demarshalled;
         return demarshalled;
-    } else {
-        return argument.value<Argument>();
     }
-}
 
-template <> inline QDBusArgument demarshallArgument<QDBusArgument>(const QVariant &argument)
+    static Argument demarshall(const QVariant &argument)
+    {
+        if (argument.userType() == qMetaTypeId<QDBusArgument>()) {
+            return demarshall(argument.value<QDBusArgument>());
+        } else {
+            return argument.value<Argument>();
+        }
+    }
+};
+
+template <> struct ArgumentDemarshaller<QDBusArgument>
 {
-    return argument.value<QDBusArgument>();
-}
+    static QDBusArgument demarshall(const QDBusArgument &argument)
+    {
+        return argument.asVariant().value<QDBusArgument>();
+    }
 
-template <> inline QVariant demarshallArgument<QVariant>(const QVariant &argument)
+    static QDBusArgument demarshall(const QVariant &argument)
+    {
+        return argument.value<QDBusArgument>();
+    }
+};
+
+// Unwraps the content of a variant, values of any other type are returned as they are. That way
+// QVariantList and QVariantMap take the elements of arrays and dictionaries of any type.
+template <> struct ArgumentDemarshaller<QVariant>
 {
-    return argument.value<QDBusVariant>().variant();
+    static QVariant demarshall(const QDBusArgument &argument)
+    {
+        if (argument.currentType() != QDBusArgument::VariantType) {
+            return argument.asVariant();
+        }
+
+        QDBusVariant variant;
+        argument >> variant;
+        return variant.variant();
+    }
+
+    static QVariant demarshall(const QVariant &argument)
+    {
+        if (argument.userType() == qMetaTypeId<QDBusVariant>()) {
+            return argument.value<QDBusVariant>().variant();
+        } else {
+            return argument;
+        }
+    }
+};
+
+template <typename Sequence> struct SequenceDemarshaller
+{
+    typedef typename Sequence::value_type Element;
+
+    static Sequence demarshall(const QDBusArgument &argument)
+    {
+        Sequence sequence;
+        argument.beginArray();
+        while (!argument.atEnd()) {
+            sequence.push_back(ArgumentDemarshaller<Element>::demarshall(argument));
+        }
+        argument.endArray();
+        return sequence;
+    }
+
+    static Sequence demarshall(const QVariant &argument)
+    {
+        if (argument.userType() == qMetaTypeId<QDBusArgument>()) {
+            return demarshall(argument.value<QDBusArgument>());
+        }
+
+        // String arrays are received as a QStringList rather than a QDBusArgument.
+        const QVariantList list = argument.toList();
+
+        Sequence sequence;
+        sequence.reserve(list.count());
+        for (const QVariant &element : list) {
+            sequence.push_back(ArgumentDemarshaller<Element>::demarshall(element));
+        }
+        return sequence;
+    }
+};
+
+template <typename Element> struct ArgumentDemarshaller<QList<Element>>
+        : SequenceDemarshaller<QList<Element>> {};
+template <typename Element> struct ArgumentDemarshaller<QVector<Element>>
+        : SequenceDemarshaller<QVector<Element>> {};
+template <typename Element> struct ArgumentDemarshaller<std::vector<Element>>
+        : SequenceDemarshaller<std::vector<Element>> {};
+
+template <typename Map> struct MapDemarshaller
+{
+    typedef typename Map::key_type Key;
+    typedef typename Map::mapped_type Value;
+
+    static Map demarshall(const QDBusArgument &argument)
+    {
+        Map map;
+        argument.beginMap();
+        while (!argument.atEnd()) {
+            argument.beginMapEntry();
+            const Key key = ArgumentDemarshaller<Key>::demarshall(argument);
+            map.insert(key, ArgumentDemarshaller<Value>::demarshall(argument));
+            argument.endMapEntry();
+        }
+        argument.endMap();
+        return map;
+    }
+
+    static Map demarshall(const QVariant &argument)
+    {
+        if (argument.userType() == qMetaTypeId<QDBusArgument>()) {
+            return demarshall(argument.value<QDBusArgument>());
+        }
+
+        const QVariantMap variants = argument.toMap();
+
+        Map map;
+        for (auto it = variants.constBegin(); it != variants.constEnd(); ++it) {
+            map.insert(
+                    ArgumentDemarshaller<Key>::demarshall(QVariant(it.key())),
+                    ArgumentDemarshaller<Value>::demarshall(it.value()));
+        }
+        return map;
+    }
+};
+
+template <typename Key, typename Value> struct ArgumentDemarshaller<QMap<Key, Value>>
+        : MapDemarshaller<QMap<Key, Value>> {};
+template <typename Key, typename Value> struct ArgumentDemarshaller<QHash<Key, Value>>
+        : MapDemarshaller<QHash<Key, Value>> {};
+
+template <std::size_t Count, typename... Elements> struct TupleDemarshaller
+{
+    typedef typename std::tuple_element<Count - 1, std::tuple<Elements...>>::type Element;
+
+    static void demarshall(const QDBusArgument &argument, std::tuple<Elements...> &tuple)
+    {
+        TupleDemarshaller<Count - 1, Elements...>::demarshall(argument, tuple);
+        std::get<Count - 1>(tuple) = ArgumentDemarshaller<Element>::demarshall(argument);
+    }
+
+    static void demarshall(const QVariantList &list, std::tuple<Elements...> &tuple)
+    {
+        TupleDemarshaller<Count - 1, Elements...>::demarshall(list, tuple);
+        std::get<Count - 1>(tuple) = ArgumentDemarshaller<Element>::demarshall(
+                    list.value(Count - 1));
+    }
+};
+
+template <typename... Elements> struct TupleDemarshaller<0, Elements...>
+{
+    static void demarshall(const QDBusArgument &, std::tuple<Elements...> &) {}
+    static void demarshall(const QVariantList &, std::tuple<Elements...> &) {}
+};
+
+template <typename... Elements> struct ArgumentDemarshaller<std::tuple<Elements...>>
+{
+    static std::tuple<Elements...> demarshall(const QDBusArgument &argument)
+    {
+        std::tuple<Elements...> tuple;
+        argument.beginStructure();
+        TupleDemarshaller<sizeof...(Elements), Elements...>::demarshall(argument, tuple);
+        argument.endStructure();
+        return tuple;
+    }
+
+    static std::tuple<Elements...> demarshall(const QVariant &argument)
+    {
+        std::tuple<Elements...> tuple;
+        if (argument.userType() == qMetaTypeId<QDBusArgument>()) {
+            tuple = demarshall(argument.value<QDBusArgument>());
+        } else {
+            TupleDemarshaller<sizeof...(Elements), Elements...>::demarshall(
+                        argument.toList(), tuple);
+        }
+        return tuple;
+    }
+};
+
+#if __cplusplus >= 201703L
+// A missing argument, for example a trailing one a service doesn't send, gives an empty optional.
+template <typename Value> struct ArgumentDemarshaller<std::optional<Value>>
+{
+    static std::optional<Value> demarshall(const QDBusArgument &argument)
+    {
+        return ArgumentDemarshaller<Value>::demarshall(argument);
+    }
+
+    static std::optional<Value> demarshall(const QVariant &argument)
+    {
+        if (!argument.isValid()) {
+            return std::nullopt;
+        }
+        return ArgumentDemarshaller<Value>::demarshall(argument);
+    }
+};
+
+// A D-Bus variant gives the first alternative whose signature matches that of its content, the
+// alternatives must be known to QMetaType.
+template <typename... Alternatives> struct ArgumentDemarshaller<std::variant<Alternatives...>>
+{
+    typedef std::variant<Alternatives...> Variant;
+
+    template <typename Alternative> static bool matches(const QVariant &value)
+    {
+        const int type = qMetaTypeId<Alternative>();
+        if (value.userType() == type) {
+            return true;
+        } else if (value.userType() == qMetaTypeId<QDBusArgument>()) {
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+            const char *signature = QDBusMetaType::typeToSignature(QMetaType(type));
+#else
+            const char *signature = QDBusMetaType::typeToSignature(type);
+#endif
+            return signature && value.value<QDBusArgument>().currentSignature()
+                    == QLatin1String(signature);
+        } else {
+            return false;
+        }
+    }
+
+    static Variant demarshall(const QDBusArgument &argument)
+    {
+        return fromContent(ArgumentDemarshaller<QVariant>::demarshall(argument));
+    }
+
+    static Variant demarshall(const QVariant &argument)
+    {
+        return fromContent(argument.userType() == qMetaTypeId<QDBusVariant>()
+                ? argument.value<QDBusVariant>().variant()
+                : argument);
+    }
+
+    static Variant fromContent(const QVariant &content)
+    {
+        Variant variant;
+        (void)((matches<Alternatives>(content)
+                && (variant = ArgumentDemarshaller<Alternatives>::demarshall(content), true))
+               || ...);
+        return variant;
+    }
+};
+#endif
+
+template <typename Argument> inline Argument demarshallArgument(const QVariant &argument)
+{
+    return ArgumentDemarshaller<Argument>::demarshall(argument);
 }
 
 inline void appendArguments(QVariantList &) {}
@@ -88,10 +345,21 @@ inline void appendArguments(QVariantList &list, Argument &&value, Arguments &&..
 template <typename... Arguments> inline QVariantList marshallArguments(Arguments &&...arguments)
 {
     QVariantList list;
+    list.reserve(sizeof...(Arguments));
     appendArguments(list, std::forward<Arguments>(arguments)...);
     return list;
 }
 
+inline void appendArguments(QDBusMessage &) {}
+
+// Streams arguments straight into the body of a message, without building an intermediate list.
+template<typename Argument, typename... Arguments>
+inline void appendArguments(QDBusMessage &message, Argument &&value, Arguments &&...arguments)
+{
+    message << marshallArgument(std::forward<Argument>(value));
+    appendArguments(message, std::forward<Arguments>(arguments)...);
+}
+
 template <typename... Arguments> inline bool send(
         const QDBusConnection &connection,
         const QString &path,
@@ -100,7 +368,7 @@ template <typename... Arguments> inline bool send(
         Arguments &&...arguments)
 {
     QDBusMessage message = QDBusMessage::createMethodCall(QString(), path, interface, method);
-    message.setArguments(marshallArguments(std::forward<Arguments>(arguments)...));
+    appendArguments(message, std::forward<Arguments>(arguments)...);
     return connection.send(message);
 }
 
@@ -116,6 +384,8 @@ template <typename... Arguments> inline bool send(
 }
 
 NEMODBUS_EXPORT QVariant demarshallDBusArgument(const QVariant &val, int depth = 0);
+NEMODBUS_EXPORT QVariant demarshallDBusArgument(
+        const QVariant &val, DemarshallOptions options, int depth = 0);
 NEMODBUS_EXPORT void registerDBusTypes();
 
 NEMODBUS_EXPORT Connection systemBus();
@@ -123,4 +393,6 @@ NEMODBUS_EXPORT Connection sessionBus();
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(NemoDBus::DemarshallOptions)
+
 #endif
@@ -54,6 +54,17 @@ QString Interface::interface() const
     return m_interface;
 }
 
+void Interface::cacheReplies(
+        const QString &method, int timeout, const QStringList &invalidatingSignals)
+{
+    Object::cacheReplies(m_interface, method, timeout, invalidatingSignals);
+}
+
+void Interface::invalidateCachedReplies(const QString &method)
+{
+    Object::invalidateCachedReplies(m_interface, method);
+}
+
 bool Interface::connectToSignal(const QString &signal, const char *slot)
 {
     return Object::connectToSignal(m_interface, signal, slot);
@@ -61,6 +61,18 @@ public:
         return Object::call(m_interface, method, std::forward<Arguments>(arguments)...);
     }
 
+    template <typename... Arguments>
+    Response *call(const Deadline &deadline, const QString &method, Arguments &&...arguments)
+    {
+        return Object::call(deadline, m_interface, method, std::forward<Arguments>(arguments)...);
+    }
+
+    template <typename... Arguments>
+    Response *coalescedCall(const QString &method, Arguments &&...arguments)
+    {
+        return Object::coalescedCall(m_interface, method, std::forward<Arguments>(arguments)...);
+    }
+
     template <typename... Arguments>
     QDBusMessage blockingCall(const QString &method, Arguments &&...arguments)
     {
@@ -73,6 +85,10 @@ public:
         Object::subscribeToProperty<T>(m_interface, property, onChanged);
     }
 
+    void cacheReplies(
+            const QString &method, int timeout, const QStringList &invalidatingSignals = QStringList());
+    void invalidateCachedReplies(const QString &method = QString());
+
     bool connectToSignal(const QString &signal, const char *slot);
 
 private:
@@ -20,6 +20,7 @@ DEFINES += \
 include(private/private.pri)
 
 SOURCES += \
+        batch.cpp \
         connection.cpp \
         dbus.cpp \
         interface.cpp \
@@ -28,7 +29,9 @@ SOURCES += \
         response.cpp
 
 PUBLIC_HEADERS += \
+        batch.h \
         connection.h \
+        coroutine.h \
         dbus.h \
         global.h \
         interface.h \
@@ -67,6 +67,20 @@ QString Object::path() const
     return m_path;
 }
 
+void Object::cacheReplies(
+        const QString &interface,
+        const QString &method,
+        int timeout,
+        const QStringList &invalidatingSignals)
+{
+    m_connection.cacheReplies(m_service, m_path, interface, method, timeout, invalidatingSignals);
+}
+
+void Object::invalidateCachedReplies(const QString &interface, const QString &method)
+{
+    m_connection.invalidateCachedReplies(m_service, m_path, interface, method);
+}
+
 bool Object::connectToSignal(const QString &interface, const QString &signal, const char *slot)
 {
     return m_connection.connectToSignal(m_service, m_path, interface, signal, m_context, slot);
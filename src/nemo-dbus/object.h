@@ -55,6 +55,24 @@ public:
                 std::forward<Arguments>(arguments)...);
     }
 
+    template <typename... Arguments>
+    Response *call(
+            const Deadline &deadline,
+            const QString &interface,
+            const QString &method,
+            Arguments &&...arguments)
+    {
+        return m_connection.call(m_context, deadline, m_service, m_path, interface, method,
+                std::forward<Arguments>(arguments)...);
+    }
+
+    template <typename... Arguments>
+    Response *coalescedCall(const QString &interface, const QString &method, Arguments &&...arguments)
+    {
+        return m_connection.coalescedCall(m_context, m_service, m_path, interface, method,
+                std::forward<Arguments>(arguments)...);
+    }
+
     template <typename... Arguments>
     QDBusMessage blockingCall(const QString &interface, const QString &method, Arguments &&...arguments)
     {
@@ -69,6 +87,13 @@ public:
         m_connection.subscribeToProperty<T>(m_context, m_service, m_path, interface, property, onChanged);
     }
 
+    void cacheReplies(
+            const QString &interface,
+            const QString &method,
+            int timeout,
+            const QStringList &invalidatingSignals = QStringList());
+    void invalidateCachedReplies(const QString &interface, const QString &method = QString());
+
     bool connectToSignal(const QString &interface, const QString &signal, const char *slot);
 
 private:
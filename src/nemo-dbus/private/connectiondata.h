@@ -37,11 +37,14 @@
 #include <nemo-dbus/response.h>
 
 #include <nemo-dbus/private/propertychanges.h>
+#include <nemo-dbus/private/replycache.h>
 
+#include <QPointer>
 #include <QSharedData>
 
 namespace NemoDBus {
 
+class Batch;
 class PropertyChanges;
 class Response;
 
@@ -61,8 +64,38 @@ public:
             const QString &method,
             Arguments &&...arguments)
     {
-        return callMethod(context, service, path, interface, method,
-                marshallArguments(std::forward<Arguments>(arguments)...));
+        QDBusMessage message = QDBusMessage::createMethodCall(service, path, interface, method);
+        appendArguments(message, std::forward<Arguments>(arguments)...);
+        return callMethod(context, message, Deadline::current());
+    }
+
+    template <typename... Arguments>
+    Response *call(
+            QObject *context,
+            const Deadline &deadline,
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method,
+            Arguments &&...arguments)
+    {
+        QDBusMessage message = QDBusMessage::createMethodCall(service, path, interface, method);
+        appendArguments(message, std::forward<Arguments>(arguments)...);
+        return callMethod(context, message, deadline);
+    }
+
+    template <typename... Arguments>
+    Response *coalescedCall(
+            QObject *context,
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method,
+            Arguments &&...arguments)
+    {
+        QDBusMessage message = QDBusMessage::createMethodCall(service, path, interface, method);
+        appendArguments(message, std::forward<Arguments>(arguments)...);
+        return coalescedCallMethod(context, message, Deadline::current());
     }
 
     template <typename... Arguments>
@@ -73,8 +106,9 @@ public:
             const QString &method,
             Arguments &&...arguments)
     {
-        return blockingCallMethod(service, path, interface, method,
-                marshallArguments(std::forward<Arguments>(arguments)...));
+        QDBusMessage message = QDBusMessage::createMethodCall(service, path, interface, method);
+        appendArguments(message, std::forward<Arguments>(arguments)...);
+        return blockingCallMethod(message);
     }
 
     template <typename T, typename Handler>
@@ -104,6 +138,8 @@ public:
         }
     }
 
+    Batch *batch(QObject *context);
+
     bool getProperty(
             QVariant *value,
             const QDBusConnection &connection,
@@ -121,6 +157,7 @@ public:
 
     QDBusConnection connection;
     QHash<QString, QHash<QString, PropertyChanges *>> propertyChanges;
+    ReplyCache replyCache;
 
 signals:
     void connected();
@@ -128,8 +165,18 @@ signals:
 
 private slots:
     void handleDisconnect();
+    void coalescedCallFinished(QDBusPendingCallWatcher *watcher);
 
 private:
+    struct CoalescedCall
+    {
+        QDBusMessage message;
+        QDBusPendingCallWatcher *watcher;
+        QVector<QPointer<Response>> responses;
+        Deadline deadline;
+        quint64 cacheGeneration;
+    };
+
     Response *callMethod(
             QObject *context,
             const QString &service,
@@ -143,10 +190,20 @@ private:
             const QString &interface,
             const QString &method,
             const QVariantList &arguments);
+    Response *callMethod(QObject *context, const QDBusMessage &message, const Deadline &deadline);
+    QDBusMessage blockingCallMethod(const QDBusMessage &message);
+    Response *coalescedCallMethod(
+            QObject *context, const QDBusMessage &message, const Deadline &deadline);
+    Response *cachedCallMethod(
+            QObject *context, const QDBusMessage &message, const Deadline &deadline);
+    Response *expiredCallMethod(
+            QObject *context, const QDBusMessage &message, const Deadline &deadline);
+    Response *createResponse(QObject *context, const Deadline &deadline);
     PropertyChanges *subscribeToObject(QObject *context, const QString &service, const QString &path);
 
     void deletePropertyListeners();
 
+    QList<CoalescedCall> m_coalescedCalls;
     const QLoggingCategory &m_logs;
 };
 
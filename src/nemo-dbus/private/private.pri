@@ -3,7 +3,13 @@ INCLUDEPATH += $$PWD
 
 PRIVATE_HEADERS += \
         $$PWD/connectiondata.h \
-        $$PWD/propertychanges.h
+        $$PWD/propertychanges.h \
+        $$PWD/replycache.h \
+        $$PWD/signatureplan.h \
+        $$PWD/stringpool.h
 
 SOURCES += \
-        $$PWD/propertychanges.cpp
+        $$PWD/propertychanges.cpp \
+        $$PWD/replycache.cpp \
+        $$PWD/signatureplan.cpp \
+        $$PWD/stringpool.cpp
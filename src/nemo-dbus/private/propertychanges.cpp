@@ -34,6 +34,7 @@
 
 #include "connectiondata.h"
 #include "response.h"
+#include "stringpool.h"
 
 #include "logging.h"
 
@@ -96,18 +97,20 @@ void PropertyChanges::getProperty(const QString &interface, const QString &prope
 void PropertyChanges::propertiesChanged(
         const QString &interface, const QVariantMap &changed, const QStringList &invalidated)
 {
+    const QString name = internString(interface);
+
     for (auto it = changed.begin(); it != changed.end(); ++it) {
         qCDebug(m_cache->logs(), "DBus property changed (%s %s %s.%s)",
                 qPrintable(m_service), qPrintable(m_path), qPrintable(interface), qPrintable(it.key()));
 
-        emit propertyChanged(interface, it.key(), it.value());
+        emit propertyChanged(name, internString(it.key()), it.value());
     }
 
     for (auto property : invalidated) {
         qCDebug(m_cache->logs(), "DBus property changed (%s %s %s.%s)",
                 qPrintable(m_service), qPrintable(m_path), qPrintable(interface), qPrintable(property));
 
-        getProperty(interface, property);
+        getProperty(name, internString(property));
     }
 }
 
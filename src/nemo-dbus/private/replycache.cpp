@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "replycache.h"
+
+#include <QDBusObjectPath>
+#include <QDBusSignature>
+#include <QDBusVariant>
+
+namespace NemoDBus {
+
+static QString methodKey(
+        const QString &service, const QString &path, const QString &interface, const QString &method)
+{
+    return service + QLatin1Char(' ') + path + QLatin1Char(' ') + interface + QLatin1Char(' ') + method;
+}
+
+static QString methodKey(const QDBusMessage &call)
+{
+    return methodKey(call.service(), call.path(), call.interface(), call.member());
+}
+
+static bool equalArguments(const QVariant &left, const QVariant &right)
+{
+    const int type = left.userType();
+
+    if (type != right.userType()) {
+        return false;
+    } else if (type == qMetaTypeId<QDBusVariant>()) {
+        return equalArguments(
+                    left.value<QDBusVariant>().variant(), right.value<QDBusVariant>().variant());
+    } else if (type == qMetaTypeId<QDBusObjectPath>()) {
+        return left.value<QDBusObjectPath>().path() == right.value<QDBusObjectPath>().path();
+    } else if (type == qMetaTypeId<QDBusSignature>()) {
+        return left.value<QDBusSignature>().signature() == right.value<QDBusSignature>().signature();
+    } else if (type == QMetaType::QVariantList) {
+        const QVariantList leftList = left.toList();
+        const QVariantList rightList = right.toList();
+
+        if (leftList.count() != rightList.count()) {
+            return false;
+        }
+        for (int i = 0; i < leftList.count(); ++i) {
+            if (!equalArguments(leftList.at(i), rightList.at(i))) {
+                return false;
+            }
+        }
+        return true;
+    } else if (type == QMetaType::QVariantMap) {
+        const QVariantMap leftMap = left.toMap();
+        const QVariantMap rightMap = right.toMap();
+
+        if (leftMap.count() != rightMap.count()) {
+            return false;
+        }
+        for (auto it = leftMap.begin(), rightIt = rightMap.begin(); it != leftMap.end(); ++it, ++rightIt) {
+            if (it.key() != rightIt.key() || !equalArguments(it.value(), rightIt.value())) {
+                return false;
+            }
+        }
+        return true;
+    } else if (type < QMetaType::User) {
+        return left == right;
+    } else {
+        // Other types, including QDBusArgument, can't be compared reliably so calls with them
+        // are never considered identical.
+        return false;
+    }
+}
+
+bool equalCalls(const QDBusMessage &left, const QDBusMessage &right)
+{
+    if (left.member() != right.member()
+            || left.path() != right.path()
+            || left.interface() != right.interface()
+            || left.service() != right.service()) {
+        return false;
+    }
+
+    const QVariantList leftArguments = left.arguments();
+    const QVariantList rightArguments = right.arguments();
+
+    if (leftArguments.count() != rightArguments.count()) {
+        return false;
+    }
+    for (int i = 0; i < leftArguments.count(); ++i) {
+        if (!equalArguments(leftArguments.at(i), rightArguments.at(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ReplyCache::ReplyCache(const QDBusConnection &connection, QObject *parent)
+    : QObject(parent)
+    , m_connection(connection)
+    , m_generation(0)
+{
+}
+
+ReplyCache::~ReplyCache()
+{
+}
+
+void ReplyCache::setConnection(const QDBusConnection &connection)
+{
+    const QList<Invalidation> invalidations = m_invalidations;
+
+    m_invalidations.clear();
+    for (const Invalidation &invalidation : invalidations) {
+        disconnectFromSignal(invalidation);
+    }
+
+    m_connection = connection;
+    clear();
+
+    for (const Invalidation &invalidation : invalidations) {
+        connectToSignal(invalidation);
+        m_invalidations.append(invalidation);
+    }
+}
+
+void ReplyCache::setTimeout(
+        const QString &service,
+        const QString &path,
+        const QString &interface,
+        const QString &method,
+        int timeout,
+        const QStringList &invalidatingSignals)
+{
+    const QString key = methodKey(service, path, interface, method);
+
+    for (int i = 0; i < m_invalidations.count();) {
+        const Invalidation invalidation = m_invalidations.at(i);
+        if (invalidation.method == method
+                && invalidation.interface == interface
+                && invalidation.path == path
+                && invalidation.service == service) {
+            m_invalidations.removeAt(i);
+            disconnectFromSignal(invalidation);
+        } else {
+            ++i;
+        }
+    }
+
+    m_entries.remove(key);
+
+    if (timeout <= 0) {
+        m_timeouts.remove(key);
+        return;
+    }
+
+    m_timeouts.insert(key, timeout);
+
+    for (const QString &signal : invalidatingSignals) {
+        const int separator = signal.lastIndexOf(QLatin1Char('.'));
+
+        Invalidation invalidation;
+        invalidation.service = service;
+        invalidation.path = path;
+        invalidation.interface = interface;
+        invalidation.method = method;
+        invalidation.signalInterface = separator != -1 ? signal.left(separator) : interface;
+        invalidation.signal = signal.mid(separator + 1);
+
+        connectToSignal(invalidation);
+        m_invalidations.append(invalidation);
+    }
+}
+
+int ReplyCache::timeout(const QDBusMessage &call) const
+{
+    return m_timeouts.isEmpty() ? 0 : m_timeouts.value(methodKey(call));
+}
+
+quint64 ReplyCache::generation() const
+{
+    return m_generation;
+}
+
+bool ReplyCache::find(const QDBusMessage &call, QDBusMessage *reply)
+{
+    const int timeout = ReplyCache::timeout(call);
+    if (timeout <= 0) {
+        return false;
+    }
+
+    const auto it = m_entries.find(methodKey(call));
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    QList<Entry> &entries = *it;
+    for (int i = 0; i < entries.count();) {
+        const Entry &entry = entries.at(i);
+        if (entry.age.hasExpired(timeout)) {
+            entries.removeAt(i);
+        } else if (equalCalls(entry.call, call)) {
+            *reply = entry.reply;
+            return true;
+        } else {
+            ++i;
+        }
+    }
+
+    if (entries.isEmpty()) {
+        m_entries.erase(it);
+    }
+
+    return false;
+}
+
+void ReplyCache::insert(const QDBusMessage &call, const QDBusMessage &reply, quint64 generation)
+{
+    const QString key = methodKey(call);
+    const int timeout = m_timeouts.value(key);
+
+    if (timeout <= 0 || generation != m_generation || reply.type() != QDBusMessage::ReplyMessage) {
+        return;
+    }
+
+    QList<Entry> &entries = m_entries[key];
+    for (int i = 0; i < entries.count();) {
+        const Entry &entry = entries.at(i);
+        if (entry.age.hasExpired(timeout) || equalCalls(entry.call, call)) {
+            entries.removeAt(i);
+        } else {
+            ++i;
+        }
+    }
+
+    Entry entry;
+    entry.call = call;
+    entry.reply = reply;
+    entry.age.start();
+
+    entries.append(entry);
+}
+
+void ReplyCache::invalidate(
+        const QString &service, const QString &path, const QString &interface, const QString &method)
+{
+    ++m_generation;
+
+    if (!method.isEmpty()) {
+        m_entries.remove(methodKey(service, path, interface, method));
+        return;
+    }
+
+    const QString prefix = methodKey(service, path, interface, QString());
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it.key().startsWith(prefix)) {
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ReplyCache::clear()
+{
+    ++m_generation;
+
+    m_entries.clear();
+}
+
+void ReplyCache::invalidatingSignal(const QDBusMessage &signal)
+{
+    static const QString propertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+
+    // Signals are matched by path, interface and name only as the sender is identified by its
+    // unique name rather than a service name.  At worst this invalidates too many replies.
+    for (const Invalidation &invalidation : m_invalidations) {
+        if (invalidation.signal != signal.member()
+                || invalidation.signalInterface != signal.interface()
+                || invalidation.path != signal.path()) {
+            continue;
+        } else if (invalidation.signalInterface == propertiesInterface
+                && invalidation.interface != propertiesInterface
+                && signal.arguments().value(0).toString() != invalidation.interface) {
+            // Only changes to the properties of the cached interface invalidate its replies,
+            // replies of the properties interface itself may depend on those of any interface.
+            continue;
+        }
+
+        invalidate(invalidation.service, invalidation.path, invalidation.interface, invalidation.method);
+    }
+}
+
+bool ReplyCache::isConnectedToSignal(const Invalidation &invalidation) const
+{
+    for (const Invalidation &existing : m_invalidations) {
+        if (existing.sameSignal(invalidation)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Both of these expect the invalidation to not be in the list of invalidations, so a signal
+// shared by several cached methods is connected to once.
+void ReplyCache::connectToSignal(const Invalidation &invalidation)
+{
+    if (isConnectedToSignal(invalidation)) {
+        return;
+    }
+
+    m_connection.connect(
+                invalidation.service,
+                invalidation.path,
+                invalidation.signalInterface,
+                invalidation.signal,
+                this,
+                SLOT(invalidatingSignal(QDBusMessage)));
+}
+
+void ReplyCache::disconnectFromSignal(const Invalidation &invalidation)
+{
+    if (isConnectedToSignal(invalidation)) {
+        return;
+    }
+
+    m_connection.disconnect(
+                invalidation.service,
+                invalidation.path,
+                invalidation.signalInterface,
+                invalidation.signal,
+                this,
+                SLOT(invalidatingSignal(QDBusMessage)));
+}
+
+}
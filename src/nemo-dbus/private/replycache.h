@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef NEMODBUS_REPLYCACHE_H
+#define NEMODBUS_REPLYCACHE_H
+
+#include <nemo-dbus/global.h>
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+namespace NemoDBus {
+
+// Returns true if two method calls have the same destination, method and arguments.  Arguments
+// which can't be compared by value are never considered equal.
+NEMODBUS_EXPORT bool equalCalls(const QDBusMessage &left, const QDBusMessage &right);
+
+// Keeps the replies to methods which have been declared free of side effects, so that a repeated
+// call with the same arguments can be answered without a round trip until the reply expires or
+// is invalidated.
+class NEMODBUS_EXPORT ReplyCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplyCache(const QDBusConnection &connection, QObject *parent = nullptr);
+    ~ReplyCache();
+
+    void setConnection(const QDBusConnection &connection);
+
+    // Caches replies to a method for timeout milliseconds, a timeout of zero stops caching.  The
+    // invalidating signals are either names of signals on the same interface or qualified with
+    // another interface name, e.g. org.freedesktop.DBus.Properties.PropertiesChanged.
+    void setTimeout(
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method,
+            int timeout,
+            const QStringList &invalidatingSignals = QStringList());
+    int timeout(const QDBusMessage &call) const;
+
+    // Changes each time replies are invalidated.  A reply is only inserted if the generation
+    // hasn't changed since its call was made.
+    quint64 generation() const;
+
+    bool find(const QDBusMessage &call, QDBusMessage *reply);
+    void insert(const QDBusMessage &call, const QDBusMessage &reply, quint64 generation);
+
+    // Discards the cached replies to a method, or to all methods of the interface if no method
+    // is given.
+    void invalidate(
+            const QString &service,
+            const QString &path,
+            const QString &interface,
+            const QString &method = QString());
+    void clear();
+
+private slots:
+    void invalidatingSignal(const QDBusMessage &signal);
+
+private:
+    struct Entry
+    {
+        QDBusMessage call;
+        QDBusMessage reply;
+        QElapsedTimer age;
+    };
+
+    struct Invalidation
+    {
+        QString service;
+        QString path;
+        QString interface;
+        QString method;
+        QString signalInterface;
+        QString signal;
+
+        bool sameSignal(const Invalidation &other) const
+        {
+            return signal == other.signal
+                    && signalInterface == other.signalInterface
+                    && path == other.path
+                    && service == other.service;
+        }
+    };
+
+    bool isConnectedToSignal(const Invalidation &invalidation) const;
+    void connectToSignal(const Invalidation &invalidation);
+    void disconnectFromSignal(const Invalidation &invalidation);
+
+    QDBusConnection m_connection;
+    QHash<QString, int> m_timeouts;
+    QHash<QString, QList<Entry>> m_entries;
+    QList<Invalidation> m_invalidations;
+    quint64 m_generation;
+};
+
+}
+
+#endif
@@ -0,0 +1,776 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "signatureplan.h"
+
+#include "dbus.h"
+#include "stringpool.h"
+
+#include <QDBusMetaType>
+#include <QDBusObjectPath>
+#include <QDBusSignature>
+#include <QDBusUnixFileDescriptor>
+#include <QDBusVariant>
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QVarLengthArray>
+#include <QDebug>
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+#include <utility>
+#endif
+
+namespace NemoDBus {
+
+namespace {
+
+/* Same limit as demarshallDBusArgument(), see the rationale there. */
+const int maximumDepth = 32;
+
+/* Replies from a misbehaving service or signatures given by scripts could
+ * in theory be of an unbounded number of distinct signatures, stop caching
+ * new plans after this many. Later signatures are compiled for each use. */
+const int maximumCachedPlans = 512;
+
+struct PlanCache
+{
+    QReadWriteLock lock;
+    QHash<QString, QSharedPointer<const SignaturePlan>> plans;
+
+    /* Placeholder types are registered once per signature, whichever plan
+     * asks first, and keep that plan for as long as the types exist */
+    QMutex typeLock;
+    QHash<QByteArray, int> placeholderTypes;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    QVector<QSharedPointer<const SignaturePlan>> placeholderPlans;
+#else
+    QHash<int, QSharedPointer<const SignaturePlan>> placeholderPlans;
+#endif
+};
+
+void marshallEmpty(QDBusArgument &argument, const SignaturePlan *plan, int index)
+{
+    switch (plan->node(index).kind) {
+    case SignaturePlan::Byte: argument << uchar(); break;
+    case SignaturePlan::Boolean: argument << bool(); break;
+    case SignaturePlan::Int16: argument << short(); break;
+    case SignaturePlan::UInt16: argument << ushort(); break;
+    case SignaturePlan::Int32: argument << int(); break;
+    case SignaturePlan::UInt32: argument << uint(); break;
+    case SignaturePlan::Int64: argument << qlonglong(); break;
+    case SignaturePlan::UInt64: argument << qulonglong(); break;
+    case SignaturePlan::Double: argument << double(); break;
+    case SignaturePlan::String: argument << QString(); break;
+    case SignaturePlan::ObjectPath: argument << QDBusObjectPath(QStringLiteral("/")); break;
+    case SignaturePlan::Signature: argument << QDBusSignature(QStringLiteral("v")); break;
+    case SignaturePlan::UnixFileDescriptor: argument << QDBusUnixFileDescriptor(); break;
+    case SignaturePlan::Variant: argument << QDBusVariant(QVariant(0)); break;
+    case SignaturePlan::ByteArray: argument << QByteArray(); break;
+    case SignaturePlan::StringList: argument << QStringList(); break;
+    case SignaturePlan::NumericArray:
+    case SignaturePlan::Array:
+        argument.beginArray(plan->metaType(index + 1));
+        argument.endArray();
+        break;
+    case SignaturePlan::Map:
+        argument.beginMap(plan->metaType(index + 1), plan->metaType(plan->nextSibling(index + 1)));
+        argument.endMap();
+        break;
+    case SignaturePlan::Structure:
+        argument.beginStructure();
+        for (int field = index + 1; field < plan->node(index).end; field = plan->nextSibling(field)) {
+            marshallEmpty(argument, plan, field);
+        }
+        argument.endStructure();
+        break;
+    }
+}
+
+void demarshallPlaceholder(const QDBusArgument &argument, void *)
+{
+    /* Nothing is ever read into a placeholder, skip over the value */
+    argument.asVariant();
+}
+
+/* QtDBus takes the element signature of arrays and maps from a
+ * registered type. A plan without a C++ type of its own is given
+ * a placeholder type instead, whose only use is to marshall an
+ * empty value of the signature when QtDBus asks for one. */
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+/* Qt 6 has no public way to register a type under a name made up at
+ * run time, so placeholders are taken from a fixed pool of distinct
+ * C++ types instead. Each one marshalls the plan of its own slot. */
+const int placeholderSlotCount = 128;
+
+struct PlaceholderType
+{
+    QMetaType metaType;
+    QDBusMetaType::MarshallFunction marshall;
+};
+
+const PlaceholderType &placeholderType(int slot);
+#else
+struct Placeholder
+{
+    const SignaturePlan *plan;
+};
+
+void marshallPlaceholder(QDBusArgument &argument, const void *data)
+{
+    marshallEmpty(argument, static_cast<const Placeholder *>(data)->plan, 0);
+}
+
+void destructPlaceholder(int, void *)
+{
+}
+
+void *constructPlaceholder(int type, void *where, const void *copy);
+#endif
+
+template <typename T> inline QVariant demarshallBasic(const QDBusArgument &argument)
+{
+    T value;
+    argument >> value;
+    return QVariant::fromValue(value);
+}
+
+/* Numeric arrays are read element by element without going through
+ * the generic array handling for each of them, optionally into a
+ * contiguous vector the receiver can copy as a block. */
+template <typename T> QVariant demarshallNumericArray(
+        const QDBusArgument &argument, DemarshallOptions options)
+{
+    QVariant result;
+
+    argument.beginArray();
+    if (options & PackNumericArrays) {
+        QVector<T> values;
+        while (!argument.atEnd()) {
+            T value;
+            argument >> value;
+            values.append(value);
+        }
+        result = QVariant::fromValue(values);
+    } else {
+        QVariantList list;
+        while (!argument.atEnd()) {
+            T value;
+            argument >> value;
+            list.append(QVariant::fromValue(value));
+        }
+        result = list;
+    }
+    argument.endArray();
+
+    return result;
+}
+
+}
+
+Q_GLOBAL_STATIC(PlanCache, planCache)
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+template <std::size_t Slot> struct SignaturePlaceholder
+{
+};
+
+namespace {
+
+template <std::size_t Slot> void marshallPlaceholderSlot(QDBusArgument &argument, const void *)
+{
+    QSharedPointer<const SignaturePlan> plan;
+    if (PlanCache *const cache = planCache()) {
+        QMutexLocker locker(&cache->typeLock);
+        plan = cache->placeholderPlans.value(int(Slot));
+    }
+    if (plan) {
+        marshallEmpty(argument, plan.data(), 0);
+    }
+}
+
+template <std::size_t... Slots>
+const PlaceholderType *placeholderTypes(std::index_sequence<Slots...>)
+{
+    static const PlaceholderType types[] = {
+        { QMetaType::fromType<SignaturePlaceholder<Slots>>(), marshallPlaceholderSlot<Slots> }...
+    };
+    return types;
+}
+
+const PlaceholderType &placeholderType(int slot)
+{
+    return placeholderTypes(std::make_index_sequence<placeholderSlotCount>())[slot];
+}
+
+}
+#else
+namespace {
+
+void *constructPlaceholder(int type, void *where, const void *copy)
+{
+    const SignaturePlan *plan = nullptr;
+    if (copy) {
+        plan = static_cast<const Placeholder *>(copy)->plan;
+    } else if (PlanCache *const cache = planCache()) {
+        QMutexLocker locker(&cache->typeLock);
+        plan = cache->placeholderPlans.value(type).data();
+    }
+    return new (where) Placeholder { plan };
+}
+
+}
+#endif
+
+SignaturePlan::SignaturePlan(const QByteArray &signature)
+    : m_signature(signature)
+{
+    const char *position = m_signature.constData();
+    const char *const end = position + m_signature.size();
+
+    // A plan describes exactly one complete type.
+    if (!compile(position, end, 1) || position != end) {
+        m_nodes.clear();
+    }
+}
+
+SignaturePlan::~SignaturePlan()
+{
+}
+
+QSharedPointer<const SignaturePlan> SignaturePlan::fromSignature(const QString &signature)
+{
+    PlanCache *const cache = planCache();
+    if (!cache) {
+        return QSharedPointer<const SignaturePlan>();
+    }
+
+    bool full;
+    {
+        QReadLocker locker(&cache->lock);
+
+        const auto it = cache->plans.constFind(signature);
+        if (it != cache->plans.constEnd()) {
+            return *it;
+        }
+        full = cache->plans.count() >= maximumCachedPlans;
+    }
+
+    QSharedPointer<SignaturePlan> plan(new SignaturePlan(signature.toLatin1()));
+    if (plan->m_nodes.isEmpty()) {
+        // Invalid signatures aren't cached, they would only take the place of valid ones.
+        return QSharedPointer<const SignaturePlan>();
+    } else if (full) {
+        return plan;
+    }
+
+    QWriteLocker locker(&cache->lock);
+
+    const auto it = cache->plans.constFind(signature);
+    if (it != cache->plans.constEnd()) {
+        // Another thread compiled the same signature in the meantime.
+        return *it;
+    } else if (cache->plans.count() < maximumCachedPlans) {
+        cache->plans.insert(signature, plan);
+    }
+    return plan;
+}
+
+QSharedPointer<const SignaturePlan> SignaturePlan::fromArgument(const QDBusArgument &argument)
+{
+    return fromSignature(argument.currentSignature());
+}
+
+QByteArray SignaturePlan::signature(int index) const
+{
+    const Node &node = m_nodes.at(index);
+    return m_signature.mid(node.offset, node.length);
+}
+
+bool SignaturePlan::compile(const char *&position, const char *end, int depth)
+{
+    if (position == end || depth > maximumDepth) {
+        return false;
+    }
+
+    const char *const begin = position;
+    const int index = m_nodes.count();
+
+    const Node placeholder = { Byte, 0, int(begin - m_signature.constData()), 0 };
+    m_nodes.append(placeholder);
+
+    Kind kind;
+    switch (*position++) {
+    case 'y': kind = Byte; break;
+    case 'b': kind = Boolean; break;
+    case 'n': kind = Int16; break;
+    case 'q': kind = UInt16; break;
+    case 'i': kind = Int32; break;
+    case 'u': kind = UInt32; break;
+    case 'x': kind = Int64; break;
+    case 't': kind = UInt64; break;
+    case 'd': kind = Double; break;
+    case 's': kind = String; break;
+    case 'o': kind = ObjectPath; break;
+    case 'g': kind = Signature; break;
+    case 'h': kind = UnixFileDescriptor; break;
+    case 'v': kind = Variant; break;
+    case 'a':
+        if (position == end) {
+            return false;
+        } else if (*position == 'y') {
+            // QtDBus extracts these in one go as QByteArray and QStringList.
+            ++position;
+            kind = ByteArray;
+        } else if (*position == 's') {
+            ++position;
+            kind = StringList;
+        } else if (*position == '{') {
+            ++position;
+
+            const int key = m_nodes.count();
+            if (!compile(position, end, depth + 1)
+                    || !isBasic(m_nodes.at(key).kind)
+                    || !compile(position, end, depth + 1)
+                    || position == end
+                    || *position++ != '}') {
+                return false;
+            }
+            kind = Map;
+        } else {
+            if (!compile(position, end, depth + 1)) {
+                return false;
+            }
+            kind = isNumeric(m_nodes.at(index + 1).kind) ? NumericArray : Array;
+        }
+        break;
+    case '(':
+        if (position == end || *position == ')') {
+            return false;
+        }
+        while (position != end && *position != ')') {
+            if (!compile(position, end, depth + 1)) {
+                return false;
+            }
+        }
+        if (position == end) {
+            return false;
+        }
+        ++position;
+        kind = Structure;
+        break;
+    default:
+        return false;
+    }
+
+    Node &node = m_nodes[index];
+    node.kind = kind;
+    node.end = m_nodes.count();
+    node.length = int(position - begin);
+
+    return true;
+}
+
+QVariant SignaturePlan::demarshall(
+        const QDBusArgument &argument, DemarshallOptions options, int depth) const
+{
+    /* Containers are walked with an explicit stack of frames rather
+     * than by recursion. The frames for the usual nesting depths fit
+     * in the inline storage, so walking a value only allocates the
+     * containers of the result.
+     *
+     * The content of a variant is walked on the same stack, with the
+     * plan of its own signature. A variant frame stays on the stack
+     * until its content is complete, and the argument the content is
+     * read from is kept on a stack of its own along with its plan. */
+    struct Frame
+    {
+        const SignaturePlan *plan;
+        int index;
+        int child;
+        QVariantList list;
+        QVariantMap map;
+        QString key;
+    };
+    QVarLengthArray<Frame, 8> stack;
+    struct Content
+    {
+        QDBusArgument argument;
+        QSharedPointer<const SignaturePlan> plan;
+    };
+    QVarLengthArray<Content, 4> contents;
+
+    const SignaturePlan *plan = this;
+    const QDBusArgument *current = &argument;
+    int index = 0;
+    QVariant value;
+
+    for (;;) {
+        const Node &node = plan->m_nodes.at(index);
+
+        if (depth + stack.count() > maximumDepth) {
+            /* Skip over the value to keep the argument positioned on the next one */
+            qWarning() << "Too deep recursion detected at signature:" << plan->signature(index);
+            current->asVariant();
+            value = QVariant();
+        } else if (node.kind == Variant) {
+            /* The content of a variant has a signature of its own */
+            QDBusVariant variant;
+            *current >> variant;
+            const QVariant content = variant.variant();
+
+            Content next;
+            if (content.userType() == qMetaTypeId<QDBusArgument>()) {
+                next.argument = content.value<QDBusArgument>();
+                next.plan = fromArgument(next.argument);
+            }
+            if (next.plan) {
+                Frame frame;
+                frame.plan = plan;
+                frame.index = index;
+                frame.child = index;
+                stack.append(frame);
+
+                contents.append(next);
+                current = &contents.last().argument;
+                plan = next.plan.data();
+                index = 0;
+                continue;
+            }
+            value = demarshallDBusArgument(content, options, depth + stack.count());
+        } else if (node.kind == Array || node.kind == Map || node.kind == Structure) {
+            Frame frame;
+            frame.plan = plan;
+            frame.index = index;
+            frame.child = index + 1;
+
+            if (node.kind == Array) {
+                current->beginArray();
+            } else if (node.kind == Map) {
+                current->beginMap();
+            } else {
+                current->beginStructure();
+                frame.list.reserve(plan->fieldCount(index));
+            }
+
+            if (node.kind == Structure || !current->atEnd()) {
+                if (node.kind == Map) {
+                    current->beginMapEntry();
+                }
+                stack.append(frame);
+                index = frame.child;
+                continue;
+            } else if (node.kind == Array) {
+                current->endArray();
+                value = QVariantList();
+            } else {
+                current->endMap();
+                value = QVariantMap();
+            }
+        } else {
+            value = plan->demarshallValue(*current, index, options, depth + stack.count());
+        }
+
+        /* Store the value in the enclosing container, and that in turn
+         * in its own enclosing container if it is now complete */
+        for (;;) {
+            if (stack.isEmpty()) {
+                return value;
+            }
+
+            Frame &frame = stack.last();
+            const Node &container = frame.plan->m_nodes.at(frame.index);
+
+            if (container.kind == Variant) {
+                /* The content is complete, continue with the argument the variant was in */
+                contents.removeLast();
+                current = contents.isEmpty() ? &argument : &contents.last().argument;
+            } else if (container.kind == Array) {
+                /* Convert dbus array to QVariantList */
+                frame.list.append(value);
+                if (!current->atEnd()) {
+                    break;
+                }
+                current->endArray();
+                value = frame.list;
+            } else if (container.kind == Map) {
+                /* Convert dbus dict to QVariantMap */
+                if (frame.child == frame.index + 1) {
+                    frame.key = frame.plan->m_nodes.at(frame.child).kind == String
+                            ? internString(value.toString())
+                            : value.toString();
+                    frame.child = frame.plan->nextSibling(frame.child);
+                    break;
+                }
+                frame.map.insert(frame.key, value);
+                current->endMapEntry();
+                if (!current->atEnd()) {
+                    current->beginMapEntry();
+                    frame.child = frame.index + 1;
+                    break;
+                }
+                current->endMap();
+                value = frame.map;
+            } else {
+                /* Convert dbus struct to QVariantList */
+                frame.list.append(value);
+                frame.child = frame.plan->nextSibling(frame.child);
+                if (frame.child < container.end) {
+                    break;
+                }
+                current->endStructure();
+                value = frame.list;
+            }
+
+            stack.removeLast();
+        }
+
+        plan = stack.last().plan;
+        index = stack.last().child;
+    }
+}
+
+int SignaturePlan::fieldCount(int index) const
+{
+    int count = 0;
+    for (int field = index + 1; field < m_nodes.at(index).end; field = nextSibling(field)) {
+        ++count;
+    }
+    return count;
+}
+
+int SignaturePlan::metaType(int index) const
+{
+    switch (m_nodes.at(index).kind) {
+    case Byte:
+        return QMetaType::UChar;
+    case Boolean:
+        return QMetaType::Bool;
+    case Int16:
+        return QMetaType::Short;
+    case UInt16:
+        return QMetaType::UShort;
+    case Int32:
+        return QMetaType::Int;
+    case UInt32:
+        return QMetaType::UInt;
+    case Int64:
+        return QMetaType::LongLong;
+    case UInt64:
+        return QMetaType::ULongLong;
+    case Double:
+        return QMetaType::Double;
+    case String:
+        return QMetaType::QString;
+    case ObjectPath:
+        return qMetaTypeId<QDBusObjectPath>();
+    case Signature:
+        return qMetaTypeId<QDBusSignature>();
+    case UnixFileDescriptor:
+        return qMetaTypeId<QDBusUnixFileDescriptor>();
+    case Variant:
+        return qMetaTypeId<QDBusVariant>();
+    case ByteArray:
+        return QMetaType::QByteArray;
+    case StringList:
+        return QMetaType::QStringList;
+    case Array:
+        /* QtDBus has types of its own for av and a{sv}, which don't need a placeholder */
+        if (m_nodes.at(index + 1).kind == Variant) {
+            return QMetaType::QVariantList;
+        }
+        break;
+    case Map:
+        if (m_nodes.at(index + 1).kind == String
+                && m_nodes.at(nextSibling(index + 1)).kind == Variant) {
+            return QMetaType::QVariantMap;
+        }
+        break;
+    case NumericArray:
+    case Structure:
+        break;
+    }
+
+    if (index == 0) {
+        const int type = m_metaType.loadAcquire();
+        return type != QMetaType::UnknownType ? type : registerMetaType();
+    } else if (const QSharedPointer<const SignaturePlan> plan
+               = fromSignature(QString::fromLatin1(signature(index)))) {
+        return plan->metaType();
+    } else {
+        return QMetaType::UnknownType;
+    }
+}
+
+int SignaturePlan::registerMetaType() const
+{
+    PlanCache *const cache = planCache();
+    if (!cache) {
+        return QMetaType::UnknownType;
+    }
+
+    QMutexLocker locker(&cache->typeLock);
+
+    int type = m_metaType.loadAcquire();
+    if (type != QMetaType::UnknownType) {
+        return type;
+    }
+
+    /* Plans of the same signature share a placeholder type */
+    type = cache->placeholderTypes.value(m_signature, QMetaType::UnknownType);
+    if (type != QMetaType::UnknownType) {
+        m_metaType.storeRelease(type);
+        return type;
+    }
+
+    /* Placeholder types can't be unregistered, they live as long as the plan cache */
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    const int slot = cache->placeholderPlans.count();
+    if (slot == placeholderSlotCount) {
+        qWarning() << "No placeholder type left, values of signature" << m_signature
+                   << "can't be marshalled";
+        return QMetaType::UnknownType;
+    }
+    cache->placeholderPlans.append(sharedFromThis());
+
+    const PlaceholderType &placeholder = placeholderType(slot);
+    type = placeholder.metaType.id();
+
+    QDBusMetaType::registerMarshallOperators(
+                placeholder.metaType, placeholder.marshall, demarshallPlaceholder);
+#else
+    const QByteArray name = "NemoDBus::SignaturePlaceholder_" + m_signature.toHex();
+    type = QMetaType::registerNormalizedType(
+                name,
+                destructPlaceholder,
+                constructPlaceholder,
+                sizeof(Placeholder),
+                QMetaType::MovableType | QMetaType::NeedsConstruction,
+                nullptr);
+    cache->placeholderPlans.insert(type, sharedFromThis());
+
+    QDBusMetaType::registerMarshallOperators(type, marshallPlaceholder, demarshallPlaceholder);
+#endif
+
+    cache->placeholderTypes.insert(m_signature, type);
+    m_metaType.storeRelease(type);
+
+    return type;
+}
+
+QVariant SignaturePlan::demarshallValue(
+        const QDBusArgument &argument, int index, DemarshallOptions options, int depth) const
+{
+    switch (m_nodes.at(index).kind) {
+    case Byte:
+        return demarshallBasic<uchar>(argument);
+    case Boolean:
+        return demarshallBasic<bool>(argument);
+    case Int16:
+        return demarshallBasic<short>(argument);
+    case UInt16:
+        return demarshallBasic<ushort>(argument);
+    case Int32:
+        return demarshallBasic<int>(argument);
+    case UInt32:
+        return demarshallBasic<uint>(argument);
+    case Int64:
+        return demarshallBasic<qlonglong>(argument);
+    case UInt64:
+        return demarshallBasic<qulonglong>(argument);
+    case Double:
+        return demarshallBasic<double>(argument);
+    case String:
+        return demarshallBasic<QString>(argument);
+    case ObjectPath: {
+        /* Convert QDBusObjectPath to QString */
+        QDBusObjectPath path;
+        argument >> path;
+        return path.path();
+    }
+    case Signature: {
+        /* Convert QDBusSignature to QString */
+        QDBusSignature signature;
+        argument >> signature;
+        return signature.signature();
+    }
+    case UnixFileDescriptor:
+        /* Leave it to the receiver to extract the file descriptor */
+        return demarshallBasic<QDBusUnixFileDescriptor>(argument);
+    case ByteArray: {
+        QByteArray bytes;
+        argument >> bytes;
+        return demarshallDBusArgument(bytes, options, depth);
+    }
+    case StringList:
+        if (index == 0) {
+            /* An argument positioned on the array itself used to be walked
+             * element by element, keep returning a QVariantList for it. Nested
+             * arrays are extracted by QtDBus as QStringList either way. */
+            QStringList strings;
+            argument >> strings;
+            QVariantList list;
+            list.reserve(strings.count());
+            for (const QString &string : strings) {
+                list.append(string);
+            }
+            return list;
+        }
+        return demarshallBasic<QStringList>(argument);
+    case NumericArray:
+        switch (m_nodes.at(index + 1).kind) {
+        case Int16:
+            return demarshallNumericArray<short>(argument, options);
+        case UInt16:
+            return demarshallNumericArray<ushort>(argument, options);
+        case Int32:
+            return demarshallNumericArray<int>(argument, options);
+        case UInt32:
+            return demarshallNumericArray<uint>(argument, options);
+        case Int64:
+            return demarshallNumericArray<qlonglong>(argument, options);
+        case UInt64:
+            return demarshallNumericArray<qulonglong>(argument, options);
+        default:
+            return demarshallNumericArray<double>(argument, options);
+        }
+    case Variant:
+    case Array:
+    case Map:
+    case Structure:
+        /* Handled by demarshall() */
+        break;
+    }
+
+    return QVariant();
+}
+
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef NEMODBUS_SIGNATUREPLAN_H
+#define NEMODBUS_SIGNATUREPLAN_H
+
+#include <nemo-dbus/dbus.h>
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QDBusArgument>
+#include <QSharedPointer>
+#include <QVariant>
+#include <QVector>
+
+namespace NemoDBus {
+
+class NEMODBUS_EXPORT SignaturePlan : public QEnableSharedFromThis<SignaturePlan>
+{
+public:
+    enum Kind {
+        Byte,
+        Boolean,
+        Int16,
+        UInt16,
+        Int32,
+        UInt32,
+        Int64,
+        UInt64,
+        Double,
+        String,
+        ObjectPath,
+        Signature,
+        UnixFileDescriptor,
+        Variant,
+        ByteArray,
+        StringList,
+        NumericArray,
+        Array,
+        Map,
+        Structure
+    };
+
+    // The nodes of a plan are stored depth first, the children of a node immediately follow it
+    // and end is the index of the first node which is not a descendant.
+    struct Node
+    {
+        Kind kind;
+        int end;
+        int offset;
+        int length;
+    };
+
+    ~SignaturePlan();
+
+    // Plans are shared from a cache. Once the cache is full a new signature gets a plan of its own,
+    // released with the last reference to it. Invalid signatures give a null plan.
+    static QSharedPointer<const SignaturePlan> fromSignature(const QString &signature);
+    static QSharedPointer<const SignaturePlan> fromArgument(const QDBusArgument &argument);
+
+    static bool isBasic(Kind kind) { return kind <= UnixFileDescriptor; }
+    static bool isNumeric(Kind kind) { return kind >= Int16 && kind <= Double; }
+
+    QByteArray signature() const { return m_signature; }
+    QByteArray signature(int index) const;
+
+    int count() const { return m_nodes.count(); }
+    const Node &node(int index) const { return m_nodes.at(index); }
+    int nextSibling(int index) const { return m_nodes.at(index).end; }
+    int fieldCount(int index) const;
+
+    // Returns a type registered with QtDBus which has the signature of a node. Containers which
+    // have no C++ type of their own get a placeholder type, suitable for passing to beginArray()
+    // or beginMap() when marshalling.
+    int metaType(int index = 0) const;
+
+    QVariant demarshall(
+            const QDBusArgument &argument,
+            DemarshallOptions options = DefaultDemarshalling,
+            int depth = 0) const;
+
+private:
+    explicit SignaturePlan(const QByteArray &signature);
+
+    bool compile(const char *&position, const char *end, int depth);
+    int registerMetaType() const;
+    QVariant demarshallValue(
+            const QDBusArgument &argument, int index, DemarshallOptions options, int depth) const;
+
+    const QByteArray m_signature;
+    QVector<Node> m_nodes;
+    mutable QAtomicInt m_metaType;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(NemoDBus::SignaturePlan::Node, Q_PRIMITIVE_TYPE);
+
+#endif
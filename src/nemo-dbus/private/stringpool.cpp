@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include "stringpool.h"
+
+#include <QReadWriteLock>
+#include <QSet>
+
+namespace NemoDBus {
+
+namespace {
+
+/* Dictionary keys and property names come from a small vocabulary,
+ * anything beyond these limits is more likely data than a name and
+ * is returned as is rather than kept alive for the process lifetime. */
+const int maximumInternedStrings = 1024;
+const int maximumInternedLength = 64;
+
+struct StringPool
+{
+    QReadWriteLock lock;
+    QSet<QString> strings;
+};
+
+}
+
+Q_GLOBAL_STATIC(StringPool, stringPool)
+
+QString internString(const QString &string)
+{
+    StringPool *const pool = stringPool();
+    if (!pool || string.isEmpty() || string.size() > maximumInternedLength) {
+        return string;
+    }
+
+    {
+        QReadLocker locker(&pool->lock);
+
+        const auto it = pool->strings.constFind(string);
+        if (it != pool->strings.constEnd()) {
+            return *it;
+        } else if (pool->strings.count() >= maximumInternedStrings) {
+            return string;
+        }
+    }
+
+    QWriteLocker locker(&pool->lock);
+
+    const auto it = pool->strings.constFind(string);
+    if (it != pool->strings.constEnd()) {
+        // Another thread interned the same string in the meantime.
+        return *it;
+    } else if (pool->strings.count() >= maximumInternedStrings) {
+        return string;
+    } else {
+        pool->strings.insert(string);
+        return string;
+    }
+}
+
+}
@@ -31,24 +31,127 @@
  */
 
 #include "response.h"
+#include "connectiondata.h"
+#include "logging.h"
 
+#include <QElapsedTimer>
 #include <QLoggingCategory>
+#include <QSharedPointer>
+#include <QThreadStorage>
+#include <QTimer>
+
+#include <climits>
 
 namespace NemoDBus {
 
+static QThreadStorage<Deadline> currentDeadline;
+
+static qint64 monotonicTime()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
+
+Deadline::Deadline()
+    : m_deadline(-1)
+{
+}
+
+Deadline Deadline::after(int msecs)
+{
+    Deadline deadline;
+    deadline.m_deadline = monotonicTime() + qMax(0, msecs);
+    return deadline;
+}
+
+Deadline Deadline::current()
+{
+    return currentDeadline.hasLocalData() ? currentDeadline.localData() : Deadline();
+}
+
+void Deadline::setCurrent(const Deadline &deadline)
+{
+    currentDeadline.setLocalData(deadline);
+}
+
+bool Deadline::isForever() const
+{
+    return m_deadline < 0;
+}
+
+bool Deadline::hasExpired() const
+{
+    return m_deadline >= 0 && monotonicTime() >= m_deadline;
+}
+
+int Deadline::remainingTime() const
+{
+    return m_deadline >= 0
+            ? int(qBound<qint64>(0, m_deadline - monotonicTime(), INT_MAX))
+            : -1;
+}
+
 Response::Response(const QLoggingCategory &logs, QObject *parent)
     : QObject(parent)
+    , m_watcher(nullptr)
     , m_logs(logs)
+    , m_cancelled(false)
+    , m_finished(false)
 {
 }
 
 Response::~Response()
 {
+    // The pending call of the watcher refers to the connection and could be stale if it outlived
+    // the last reference to the connection, so the watcher is deleted while the response still
+    // holds its reference.  The QObject destructor would otherwise only delete it after the
+    // members have been destroyed.
+    delete m_watcher;
+}
+
+const QVariant &Response::argument(const QVariantList &arguments, int index)
+{
+    static const QVariant null;
+
+    return index < arguments.count() ? arguments.at(index) : null;
+}
+
+void Response::cancel()
+{
+    if (!m_cancelled) {
+        m_cancelled = true;
+
+        // Anything captured by the handlers is released immediately, the response itself is
+        // deleted from the event loop as it may be cancelled from within a handler.
+        disconnect(this, &Response::success, nullptr, nullptr);
+        disconnect(this, &Response::failure, nullptr, nullptr);
+        deleteLater();
+    }
+}
+
+void Response::watch(const QDBusPendingCall &call)
+{
+    m_watcher = new QDBusPendingCallWatcher(call, this);
+    connect(m_watcher, &QDBusPendingCallWatcher::finished, this, [this]() {
+        callFinished(m_watcher->reply());
+    });
+}
+
+void Response::callFinished(const QDBusMessage &reply)
+{
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        callError(QDBusError(reply), reply);
+    } else {
+        callReturn(reply);
+    }
 }
 
 void Response::callReturn(const QDBusMessage &message)
 {
-    deleteLater();
+    if (m_cancelled) {
+        return;
+    }
 
     qCDebug(logs(), "DBus reply (%s %s %s.%s)",
             qPrintable(message.service()),
@@ -56,12 +159,14 @@ void Response::callReturn(const QDBusMessage &message)
             qPrintable(message.interface()),
             qPrintable(message.member()));
 
-    emit success(message.arguments());
+    finish(message.arguments());
 }
 
 void Response::callError(const QDBusError &error, const QDBusMessage &message)
 {
-    deleteLater();
+    if (m_cancelled) {
+        return;
+    }
 
     qCWarning(logs(), "DBus error (%s %s %s.%s): %s %s",
               qPrintable(message.service()),
@@ -71,7 +176,178 @@ void Response::callError(const QDBusError &error, const QDBusMessage &message)
               qPrintable(error.name()),
               qPrintable(error.message()));
 
+    fail(error);
+}
+
+void Response::finish(const QVariantList &arguments)
+{
+    if (m_cancelled || m_finished) {
+        return;
+    }
+
+    m_finished = true;
+    deleteLater();
+
+    const Deadline previous = Deadline::current();
+    Deadline::setCurrent(m_deadline);
+
+    emit success(arguments);
+
+    Deadline::setCurrent(previous);
+}
+
+void Response::fail(const QDBusError &error)
+{
+    if (m_cancelled || m_finished) {
+        return;
+    }
+
+    m_finished = true;
+    deleteLater();
+
+    const Deadline previous = Deadline::current();
+    Deadline::setCurrent(m_deadline);
+
     emit failure(error);
+
+    Deadline::setCurrent(previous);
+}
+
+QDBusError Response::destroyedError()
+{
+    return QDBusError(
+                QDBusError::NoReply,
+                QStringLiteral("The response was destroyed before a reply was received"));
+}
+
+Response *Response::chain(QObject *context) const
+{
+    const auto response = new Response(m_logs, context);
+    response->m_connection = m_connection;
+    response->m_deadline = m_deadline;
+
+    return response;
+}
+
+void Response::forward(Response *response)
+{
+    if (!response) {
+        finish(QVariantList());
+        return;
+    }
+
+    connect(response, &Response::success, this, &Response::finish);
+    connect(response, &Response::failure, this, &Response::fail);
+    // Once the response has finished this has too, and failing does nothing.
+    connect(response, &QObject::destroyed, this, [this]() {
+        fail(destroyedError());
+    });
+}
+
+namespace {
+
+struct CombinedResponses
+{
+    explicit CombinedResponses(int count)
+        : arguments(count)
+        , finished(count, false)
+        , remaining(count)
+    {
+    }
+
+    QVector<QVariantList> arguments;
+    QVector<bool> finished;
+    int remaining;
+};
+
+}
+
+Response *Response::whenAll(QObject *context, const QVector<Response *> &responses)
+{
+    Response * const all = responses.isEmpty()
+            ? new Response(dbus(), context)
+            : responses.first()->chain(context);
+    all->m_deadline = Deadline::current();
+
+    if (responses.isEmpty()) {
+        QTimer::singleShot(0, all, [all]() {
+            all->finish(QVariantList());
+        });
+        return all;
+    }
+
+    const QSharedPointer<CombinedResponses> state(new CombinedResponses(responses.count()));
+
+    for (int i = 0; i < responses.count(); ++i) {
+        Response * const response = responses.at(i);
+
+        connect(response, &Response::success, all, [all, state, i](const QVariantList &arguments) {
+            state->arguments[i] = arguments;
+            state->finished[i] = true;
+
+            if (--state->remaining == 0) {
+                QVariantList combined;
+                for (const QVariantList &responseArguments : state->arguments) {
+                    combined += responseArguments;
+                }
+                all->finish(combined);
+            }
+        });
+        connect(response, &Response::failure, all, [all, state, i](const QDBusError &error) {
+            state->finished[i] = true;
+            all->fail(error);
+        });
+        connect(response, &QObject::destroyed, all, [all, state, i]() {
+            if (!state->finished[i]) {
+                all->fail(destroyedError());
+            }
+        });
+    }
+
+    return all;
+}
+
+Response *Response::whenAny(QObject *context, const QVector<Response *> &responses)
+{
+    Response * const any = responses.isEmpty()
+            ? new Response(dbus(), context)
+            : responses.first()->chain(context);
+    any->m_deadline = Deadline::current();
+
+    if (responses.isEmpty()) {
+        QTimer::singleShot(0, any, [any]() {
+            any->fail(QDBusError(
+                          QDBusError::InvalidArgs, QStringLiteral("No responses to wait for")));
+        });
+        return any;
+    }
+
+    const QSharedPointer<CombinedResponses> state(new CombinedResponses(responses.count()));
+
+    for (int i = 0; i < responses.count(); ++i) {
+        Response * const response = responses.at(i);
+
+        connect(response, &Response::success, any, [any, state, i](const QVariantList &arguments) {
+            state->finished[i] = true;
+            any->finish(arguments);
+        });
+        connect(response, &Response::failure, any, [any, state, i](const QDBusError &error) {
+            state->finished[i] = true;
+            if (--state->remaining == 0) {
+                any->fail(error);
+            }
+        });
+        connect(response, &QObject::destroyed, any, [any, state, i]() {
+            if (!state->finished[i]) {
+                state->finished[i] = true;
+                if (--state->remaining == 0) {
+                    any->fail(destroyedError());
+                }
+            }
+        });
+    }
+
+    return any;
 }
 
 }
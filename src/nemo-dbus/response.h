@@ -37,9 +37,64 @@
 
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
+#include <QExplicitlySharedDataPointer>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QSharedPointer>
+#include <QVector>
 
 namespace NemoDBus {
 
+class ConnectionData;
+
+template <std::size_t... Indexes> struct ArgumentIndexes {};
+
+template <std::size_t Count, std::size_t... Indexes> struct MakeArgumentIndexes
+        : MakeArgumentIndexes<Count - 1, Count - 1, Indexes...> {};
+template <std::size_t... Indexes> struct MakeArgumentIndexes<0, Indexes...>
+{
+    typedef ArgumentIndexes<Indexes...> type;
+};
+
+// The point in time by which a call must be answered.  Calls made without an explicit deadline
+// from the handler of a response inherit the deadline of that response, so a chain of calls
+// fails together once its deadline has passed.  A call whose deadline passes, whether before it
+// is made or while it is pending, fails with a QDBusError::NoReply error.
+class NEMODBUS_EXPORT Deadline
+{
+public:
+    Deadline();
+
+    static Deadline after(int msecs);
+    static Deadline current();
+
+    bool isForever() const;
+    bool hasExpired() const;
+
+    // Returns the milliseconds left before the deadline, or -1 if there is no deadline.
+    int remainingTime() const;
+
+private:
+    friend class Response;
+
+    static void setCurrent(const Deadline &deadline);
+
+    qint64 m_deadline;
+};
+
+template <typename T> struct FutureResult
+{
+    static void report(QFutureInterface<T> &future, const QVariantList &arguments)
+    {
+        future.reportResult(demarshallArgument<T>(arguments.value(0)));
+    }
+};
+
+template <> struct FutureResult<void>
+{
+    static void report(QFutureInterface<void> &, const QVariantList &) {}
+};
+
 class NEMODBUS_EXPORT Response : public QObject
 {
     Q_OBJECT
@@ -50,7 +105,8 @@ public:
     void onFinished(const Handler &handler)
     {
         connect(this, &Response::success, [handler](const QVariantList &arguments) {
-            invoke<Handler, Arguments...>(handler, arguments);
+            invoke<Arguments...>(
+                        handler, arguments, typename MakeArgumentIndexes<sizeof...(Arguments)>::type());
         });
     }
 
@@ -61,41 +117,116 @@ public:
         });
     }
 
+    // Returns a response which finishes with the reply to the call the continuation makes once
+    // this response has finished.  The continuation receives the arguments of this response and
+    // returns the response of its call, or nullptr to finish without arguments.  If either call
+    // fails the returned response fails with the same error.
+    template <typename... Arguments, typename Continuation>
+    Response *then(const Continuation &continuation)
+    {
+        Response * const next = chain(parent());
+        const QSharedPointer<bool> resolved(new bool(false));
+
+        connect(this, &Response::success, next, [next, continuation, resolved](
+                    const QVariantList &arguments) {
+            *resolved = true;
+
+            Response *response = nullptr;
+            invoke<Arguments...>([&response, &continuation](Arguments &&...values) {
+                response = continuation(std::forward<Arguments>(values)...);
+            }, arguments, typename MakeArgumentIndexes<sizeof...(Arguments)>::type());
+            next->forward(response);
+        });
+        connect(this, &Response::failure, next, &Response::fail);
+        connect(this, &QObject::destroyed, next, [next, resolved]() {
+            if (!*resolved) {
+                next->fail(destroyedError());
+            }
+        });
+
+        return next;
+    }
+
+    // Returns a response which finishes when all responses have finished, with the arguments of
+    // each response in order, or fails with the first error.
+    static Response *whenAll(QObject *context, const QVector<Response *> &responses);
+    // Returns a response which finishes with the arguments of the first response to finish, or
+    // fails with the last error if all responses fail.
+    static Response *whenAny(QObject *context, const QVector<Response *> &responses);
+
+    // Returns a future which finishes with the first argument of the reply, or is canceled if
+    // the call fails or the response is destroyed before a reply is received.
+    template <typename T = void> QFuture<T> future()
+    {
+        QFutureInterface<T> future;
+        future.reportStarted();
+
+        connect(this, &Response::success, [future](const QVariantList &arguments) mutable {
+            FutureResult<T>::report(future, arguments);
+            future.reportFinished();
+        });
+        connect(this, &Response::failure, [future]() mutable {
+            future.reportCanceled();
+            future.reportFinished();
+        });
+        connect(this, &QObject::destroyed, [future]() mutable {
+            if (!future.isFinished()) {
+                future.reportCanceled();
+                future.reportFinished();
+            }
+        });
+
+        return future.future();
+    }
+
+    // Disconnects the handlers and ignores the reply, if one is still received.
+    void cancel();
+
 signals:
     void success(const QVariantList &arguments);
     void failure(const QDBusError &error);
 
-private slots:
-    void callReturn(const QDBusMessage &message);
-    void callError(const QDBusError &error, const QDBusMessage &message);
-
 private:
     friend class ConnectionData;
 
-    template <typename Handler> static void invoke(const Handler &handler, const QVariantList &)
-    {
-        handler();
-    }
-    template <typename Handler, typename Argument0> static void invoke(
-            const Handler &handler, const QVariantList &arguments)
-    {
-        handler(demarshallArgument<Argument0>(arguments.value(0)));
-    }
-    template <typename Handler, typename Argument0, typename Argument1> static void invoke(
-            const Handler &handler, const QVariantList &arguments)
+    void watch(const QDBusPendingCall &call);
+    void callFinished(const QDBusMessage &reply);
+    void callReturn(const QDBusMessage &message);
+    void callError(const QDBusError &error, const QDBusMessage &message);
+
+    template <typename... Arguments, typename Handler, std::size_t... Indexes>
+    static void invoke(
+            const Handler &handler, const QVariantList &arguments, ArgumentIndexes<Indexes...>)
     {
-        handler(demarshallArgument<Argument0>(arguments.value(0)),
-                demarshallArgument<Argument1>(arguments.value(1)));
+        (void)arguments;
+        handler(demarshallArgument<Arguments>(argument(arguments, Indexes))...);
     }
 
+    // Returns a reference to the argument at index, or to a null variant if the reply has
+    // fewer arguments.
+    static const QVariant &argument(const QVariantList &arguments, int index);
+
     explicit Response(const QLoggingCategory &logs, QObject *parent);
 
+    static QDBusError destroyedError();
+
+    Response *chain(QObject *context) const;
+    void forward(Response *response);
+    void finish(const QVariantList &arguments);
+    void fail(const QDBusError &error);
+
     const QLoggingCategory &logs()
     {
         return m_logs;
     }
 
+    // Keeps the connection alive for as long as a reply may be delivered to the response.
+    QExplicitlySharedDataPointer<ConnectionData> m_connection;
+    QDBusPendingCallWatcher *m_watcher;
     const QLoggingCategory &m_logs;
+    Deadline m_deadline;
+    bool m_cancelled;
+    bool m_finished;
 };
 
 }
@@ -24,6 +24,11 @@
 
 #include "declarativedbus.h"
 
+#include "private/replycache.h"
+
+Q_GLOBAL_STATIC_WITH_ARGS(NemoDBus::ReplyCache, sessionReplyCache, (QDBusConnection::sessionBus()))
+Q_GLOBAL_STATIC_WITH_ARGS(NemoDBus::ReplyCache, systemReplyCache, (QDBusConnection::systemBus()))
+
 DeclarativeDBus::DeclarativeDBus(QObject *parent)
     : QObject(parent)
 {
@@ -41,3 +46,12 @@ QDBusConnection DeclarativeDBus::connection(DeclarativeDBus::BusType bus)
         return QDBusConnection::systemBus();
     }
 }
+
+NemoDBus::ReplyCache *DeclarativeDBus::replyCache(DeclarativeDBus::BusType bus)
+{
+    if (bus == SessionBus) {
+        return sessionReplyCache();
+    } else {
+        return systemReplyCache();
+    }
+}
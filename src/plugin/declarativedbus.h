@@ -28,6 +28,10 @@
 #include <QObject>
 #include <QDBusConnection>
 
+namespace NemoDBus {
+class ReplyCache;
+}
+
 class DeclarativeDBus : public QObject
 {
     Q_OBJECT
@@ -43,6 +47,7 @@ public:
     };
 
     static QDBusConnection connection(BusType bus);
+    static NemoDBus::ReplyCache *replyCache(BusType bus);
 };
 
 #endif
@@ -479,6 +479,9 @@ bool DeclarativeDBusAdaptor::handleMessage(const QDBusMessage &message,
 
     Emit a signal with the given \a name and \a arguments. If \a arguments is undefined (the
     default if not specified), then the signal will be emitted without arguments.
+
+    An \c ArrayBuffer argument is emitted as a byte array and a typed array as an array of its
+    element type, for example an \c Int32Array as \c ai.
 */
 void DeclarativeDBusAdaptor::emitSignal(const QString &name, const QJSValue &arguments)
 {
@@ -0,0 +1,830 @@
+/****************************************************************************************
+**
+** Copyright (C) 2026 Jolla Ltd.
+** All rights reserved.
+**
+** You may use this file under the terms of the GNU Lesser General
+** Public License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+** Lesser General Public License for more details.
+**
+****************************************************************************************/
+
+#include "declarativedbusconverter.h"
+
+#include "private/signatureplan.h"
+
+#include <QDBusObjectPath>
+#include <QDBusSignature>
+#include <QDBusUnixFileDescriptor>
+#include <QDBusVariant>
+#include <QJSEngine>
+#include <QJSValueIterator>
+#include <qnumeric.h>
+#include <QDebug>
+
+using NemoDBus::SignaturePlan;
+
+namespace {
+
+/* Same limit as demarshallDBusArgument(), see the rationale there. */
+const int maximumDepth = 32;
+
+template <typename T> inline T extract(const QDBusArgument &argument)
+{
+    T value;
+    argument >> value;
+    return value;
+}
+
+template <typename T> QJSValue toNumberArray(QJSEngine *engine, const QVector<T> &values)
+{
+    QJSValue array = engine->newArray(values.count());
+    for (int i = 0; i < values.count(); ++i) {
+        array.setProperty(i, double(values.at(i)));
+    }
+    return array;
+}
+
+template <typename T> QJSValue toTypedArray(
+        QJSEngine *engine, const char *constructorName, const QVector<T> &values)
+{
+    /* The element data is copied into the array buffer as one block */
+    QJSValue constructor = engine->globalObject().property(QLatin1String(constructorName));
+    if (!constructor.isCallable()) {
+        return toNumberArray(engine, values);
+    }
+
+    const QByteArray data(
+                reinterpret_cast<const char *>(values.constData()), values.count() * sizeof(T));
+    return constructor.callAsConstructor(QJSValueList() << engine->toScriptValue(data));
+}
+
+template <typename T> QJSValue toNumericArray(
+        QJSEngine *engine,
+        const QDBusArgument &argument,
+        NemoDBus::DemarshallOptions options,
+        const char *constructorName)
+{
+    QJSValue array;
+
+    argument.beginArray();
+    if (options & NemoDBus::PackNumericArrays) {
+        QVector<T> values;
+        while (!argument.atEnd()) {
+            values.append(extract<T>(argument));
+        }
+        array = constructorName
+                ? toTypedArray(engine, constructorName, values)
+                : toNumberArray(engine, values);
+    } else {
+        array = engine->newArray();
+        for (quint32 i = 0; !argument.atEnd(); ++i) {
+            array.setProperty(i, double(extract<T>(argument)));
+        }
+    }
+    argument.endArray();
+
+    return array;
+}
+
+
+template<typename T> T fromNumber(double number)
+{
+    /* Rounds like the conversions of QVariant */
+    return qIsFinite(number) ? static_cast<T>(qRound64(number)) : T();
+}
+
+template<> double fromNumber<double>(double number)
+{
+    return number;
+}
+
+template<typename T> QList<T> toQList(const QJSValue &array)
+{
+    /* Read the elements directly instead of first converting the
+     * whole array and then each of the elements from a variant */
+    const quint32 length = array.property(QLatin1String("length")).toUInt();
+
+    QList<T> arr;
+    arr.reserve(length);
+    for (quint32 i = 0; i < length; ++i) {
+        arr << fromNumber<T>(array.property(i).toNumber());
+    }
+    return arr;
+}
+
+bool flattenNumericArray(QVariant &var, const QJSValue &array, int typeChar)
+{
+    bool res = true;
+
+    switch (typeChar) {
+    case 'q': // UINT16
+        var = QVariant::fromValue(toQList<quint16>(array));
+        break;
+    case 'u': // UINT32
+        var = QVariant::fromValue(toQList<quint32>(array));
+        break;
+    case 't': // UINT64
+        var = QVariant::fromValue(toQList<quint64>(array));
+        break;
+    case 'n': // INT16
+        var = QVariant::fromValue(toQList<qint16>(array));
+        break;
+    case 'i': // INT32
+        var = QVariant::fromValue(toQList<qint32>(array));
+        break;
+    case 'x': // INT64
+        var = QVariant::fromValue(toQList<qint64>(array));
+        break;
+    case 'd': // DOUBLE
+        var = QVariant::fromValue(toQList<double>(array));
+        break;
+    default:
+        res = false;
+        break;
+    }
+
+    return res;
+}
+
+/* Collects the elements of an array into a list of one type, as long as
+ * all of them convert to a variant of that type. */
+template <typename List> bool toUniformList(
+        QVariant &var, const QJSValue &array, quint32 length, int type)
+{
+    List values;
+    values.reserve(length);
+    for (quint32 i = 0; i < length; ++i) {
+        const QVariant element = array.property(i).toVariant();
+        if (element.userType() != type) {
+            return false;
+        }
+        values.append(element.value<typename List::value_type>());
+    }
+    var = QVariant::fromValue(values);
+    return true;
+}
+
+/* Arrays whose elements all are strings, booleans, integers or doubles
+ * are passed as arrays of that type, which is guessed from the first
+ * element and the elements collected in a single pass over the array.
+ * Anything else is wrapped element by element in variant containers. */
+QVariant guessArray(const QJSValue &array)
+{
+    const quint32 length = array.property(QLatin1String("length")).toUInt();
+
+    if (length > 0) {
+        QVariant var;
+        const int type = array.property(0).toVariant().userType();
+
+        switch (type) {
+        case QMetaType::QString:
+            if (toUniformList<QStringList>(var, array, length, type))
+                return var;
+            break;
+        case QMetaType::Bool:
+            if (toUniformList<QList<bool> >(var, array, length, type))
+                return var;
+            break;
+        case QMetaType::Int:
+            if (toUniformList<QList<int> >(var, array, length, type))
+                return var;
+            break;
+        case QMetaType::Double:
+            if (toUniformList<QList<double> >(var, array, length, type))
+                return var;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return array.toVariant();
+}
+
+/* ArrayBuffers and typed arrays are told apart from other objects by
+ * their byteLength property. Returns the name of their constructor and
+ * their bytes, or the bytes of the part of the buffer a typed array
+ * views. The bytes of a buffer, or of a typed array viewing all of its
+ * buffer, are shared with the engine where it allows. The part of the
+ * buffer a narrower view covers is copied out of it. */
+QString binaryData(const QJSValue &value, QByteArray *bytes)
+{
+    if (!value.isObject() || value.isArray() || !value.hasProperty(QLatin1String("byteLength"))) {
+        return QString();
+    }
+
+    const QString type = value.property(QLatin1String("constructor"))
+            .property(QLatin1String("name")).toString();
+
+    if (type == QLatin1String("ArrayBuffer")) {
+        *bytes = value.toVariant().toByteArray();
+    } else {
+        const QJSValue buffer = value.property(QLatin1String("buffer"));
+        if (!buffer.isObject()) {
+            return QString();
+        }
+
+        const int offset = value.property(QLatin1String("byteOffset")).toInt();
+        const int length = value.property(QLatin1String("byteLength")).toInt();
+        *bytes = buffer.toVariant().toByteArray().mid(offset, length);
+    }
+
+    return type;
+}
+
+/* ArrayBuffers and DataViews have no elements of their own to convert */
+bool isBufferData(const QString &type)
+{
+    return type == QLatin1String("ArrayBuffer") || type == QLatin1String("DataView");
+}
+
+bool isByteData(const QString &type)
+{
+    return type == QLatin1String("ArrayBuffer")
+            || type == QLatin1String("DataView")
+            || type == QLatin1String("Uint8Array")
+            || type == QLatin1String("Uint8ClampedArray")
+            || type == QLatin1String("Int8Array");
+}
+
+/* The typed array whose elements have the layout of a D-Bus numeric type */
+QLatin1String typedArrayName(SignaturePlan::Kind kind)
+{
+    switch (kind) {
+    case SignaturePlan::Int16: return QLatin1String("Int16Array");
+    case SignaturePlan::UInt16: return QLatin1String("Uint16Array");
+    case SignaturePlan::Int32: return QLatin1String("Int32Array");
+    case SignaturePlan::UInt32: return QLatin1String("Uint32Array");
+    case SignaturePlan::Double: return QLatin1String("Float64Array");
+    default: return QLatin1String("");
+    }
+}
+
+template <typename T, typename Element = T> QList<T> fromBinaryData(const QByteArray &bytes)
+{
+    /* Typed arrays are always aligned to their element size */
+    const Element *elements = reinterpret_cast<const Element *>(bytes.constData());
+    const int count = bytes.size() / int(sizeof(Element));
+
+    QList<T> values;
+    values.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        values.append(T(elements[i]));
+    }
+    return values;
+}
+
+template <typename T> void marshallBinaryData(QDBusArgument &argument, const QByteArray &bytes)
+{
+    const T *elements = reinterpret_cast<const T *>(bytes.constData());
+    const int count = bytes.size() / int(sizeof(T));
+
+    argument.beginArray(qMetaTypeId<T>());
+    for (int i = 0; i < count; ++i) {
+        argument << elements[i];
+    }
+    argument.endArray();
+}
+
+/* Converts binary data to the D-Bus array with the element type of the
+ * typed array, or to a byte array for buffers and byte arrays. */
+QVariant fromBinaryData(const QString &type, const QByteArray &bytes)
+{
+    if (type == QLatin1String("Int16Array")) {
+        return QVariant::fromValue(fromBinaryData<qint16>(bytes));
+    } else if (type == QLatin1String("Uint16Array")) {
+        return QVariant::fromValue(fromBinaryData<quint16>(bytes));
+    } else if (type == QLatin1String("Int32Array")) {
+        return QVariant::fromValue(fromBinaryData<qint32>(bytes));
+    } else if (type == QLatin1String("Uint32Array")) {
+        return QVariant::fromValue(fromBinaryData<quint32>(bytes));
+    } else if (type == QLatin1String("Float32Array")) {
+        return QVariant::fromValue(fromBinaryData<double, float>(bytes));
+    } else if (type == QLatin1String("Float64Array")) {
+        return QVariant::fromValue(fromBinaryData<double>(bytes));
+    } else {
+        return bytes;
+    }
+}
+
+QByteArray toByteArray(const QJSValue &array)
+{
+    const quint32 length = array.property(QLatin1String("length")).toUInt();
+
+    QByteArray bytes;
+    bytes.reserve(length);
+    for (quint32 i = 0; i < length; ++i) {
+        bytes.append(static_cast<char>(static_cast<uchar>(array.property(i).toUInt())));
+    }
+    return bytes;
+}
+
+QStringList toStringList(const QJSValue &array)
+{
+    const quint32 length = array.property(QLatin1String("length")).toUInt();
+
+    QStringList strings;
+    strings.reserve(length);
+    for (quint32 i = 0; i < length; ++i) {
+        strings.append(array.property(i).toString());
+    }
+    return strings;
+}
+
+QVariant toBasicArgument(SignaturePlan::Kind kind, const QJSValue &value)
+{
+    switch (kind) {
+    case SignaturePlan::Byte:
+        return QVariant::fromValue(static_cast<quint8>(value.toUInt()));
+    case SignaturePlan::Boolean:
+        return value.toBool();
+    case SignaturePlan::Int16:
+        return QVariant::fromValue(static_cast<qint16>(value.toInt()));
+    case SignaturePlan::UInt16:
+        return QVariant::fromValue(static_cast<quint16>(value.toUInt()));
+    case SignaturePlan::Int32:
+        return QVariant::fromValue(static_cast<qint32>(value.toInt()));
+    case SignaturePlan::UInt32:
+        return QVariant::fromValue(static_cast<quint32>(value.toUInt()));
+    case SignaturePlan::Int64:
+        return QVariant::fromValue(static_cast<qint64>(value.toVariant().toLongLong()));
+    case SignaturePlan::UInt64:
+        return QVariant::fromValue(static_cast<quint64>(value.toVariant().toULongLong()));
+    case SignaturePlan::Double:
+        return value.toNumber();
+    case SignaturePlan::String:
+        return value.toString();
+    case SignaturePlan::ObjectPath:
+        return QVariant::fromValue(QDBusObjectPath(value.toString()));
+    case SignaturePlan::Signature:
+        return QVariant::fromValue(QDBusSignature(value.toString()));
+    case SignaturePlan::UnixFileDescriptor:
+        return QVariant::fromValue(QDBusUnixFileDescriptor(value.toInt()));
+    default:
+        return QVariant();
+    }
+}
+
+void marshallBasic(QDBusArgument &argument, SignaturePlan::Kind kind, const QJSValue &value)
+{
+    switch (kind) {
+    case SignaturePlan::Byte:
+        argument << static_cast<quint8>(value.toUInt());
+        break;
+    case SignaturePlan::Boolean:
+        argument << value.toBool();
+        break;
+    case SignaturePlan::Int16:
+        argument << static_cast<qint16>(value.toInt());
+        break;
+    case SignaturePlan::UInt16:
+        argument << static_cast<quint16>(value.toUInt());
+        break;
+    case SignaturePlan::Int32:
+        argument << static_cast<qint32>(value.toInt());
+        break;
+    case SignaturePlan::UInt32:
+        argument << static_cast<quint32>(value.toUInt());
+        break;
+    case SignaturePlan::Int64:
+        argument << static_cast<qint64>(value.toVariant().toLongLong());
+        break;
+    case SignaturePlan::UInt64:
+        argument << static_cast<quint64>(value.toVariant().toULongLong());
+        break;
+    case SignaturePlan::Double:
+        argument << value.toNumber();
+        break;
+    case SignaturePlan::String:
+        argument << value.toString();
+        break;
+    case SignaturePlan::ObjectPath:
+        argument << QDBusObjectPath(value.toString());
+        break;
+    case SignaturePlan::Signature:
+        argument << QDBusSignature(value.toString());
+        break;
+    case SignaturePlan::UnixFileDescriptor:
+        argument << QDBusUnixFileDescriptor(value.toInt());
+        break;
+    default:
+        break;
+    }
+}
+
+}
+
+DeclarativeDBusConverter::DeclarativeDBusConverter(
+        QJSEngine *engine, NemoDBus::DemarshallOptions options)
+    : m_engine(engine)
+    , m_options(options)
+{
+}
+
+QJSValue DeclarativeDBusConverter::toScriptValue(const QVariant &argument, int depth) const
+{
+    const int type = argument.userType();
+
+    if (type == qMetaTypeId<QDBusArgument>()) {
+        const QDBusArgument dbusArgument = argument.value<QDBusArgument>();
+        const QSharedPointer<const SignaturePlan> plan = SignaturePlan::fromArgument(dbusArgument);
+        if (plan) {
+            return toScriptValue(dbusArgument, plan.data(), 0, depth + 1);
+        }
+    } else if (type == qMetaTypeId<QDBusVariant>()) {
+        return toScriptValue(argument.value<QDBusVariant>().variant(), depth + 1);
+    }
+
+    /* Basic values and anything without a usable plan */
+    return fromVariant(NemoDBus::demarshallDBusArgument(argument, m_options, depth));
+}
+
+QJSValue DeclarativeDBusConverter::fromVariant(const QVariant &value) const
+{
+    const int type = value.userType();
+
+    if (type == qMetaTypeId<QVariantList>()) {
+        const QVariantList list = value.toList();
+        QJSValue array = m_engine->newArray(list.count());
+        for (int i = 0; i < list.count(); ++i) {
+            array.setProperty(i, fromVariant(list.at(i)));
+        }
+        return array;
+    } else if (type == qMetaTypeId<QVariantMap>()) {
+        const QVariantMap map = value.toMap();
+        QJSValue object = m_engine->newObject();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            object.setProperty(it.key(), fromVariant(it.value()));
+        }
+        return object;
+    } else if (type == qMetaTypeId<QVector<short> >()) {
+        return toTypedArray(m_engine, "Int16Array", value.value<QVector<short> >());
+    } else if (type == qMetaTypeId<QVector<ushort> >()) {
+        return toTypedArray(m_engine, "Uint16Array", value.value<QVector<ushort> >());
+    } else if (type == qMetaTypeId<QVector<int> >()) {
+        return toTypedArray(m_engine, "Int32Array", value.value<QVector<int> >());
+    } else if (type == qMetaTypeId<QVector<uint> >()) {
+        return toTypedArray(m_engine, "Uint32Array", value.value<QVector<uint> >());
+    } else if (type == qMetaTypeId<QVector<double> >()) {
+        return toTypedArray(m_engine, "Float64Array", value.value<QVector<double> >());
+    } else if (type == qMetaTypeId<QVector<qlonglong> >()) {
+        /* 64 bit integers don't fit a typed array, use numbers like elsewhere */
+        return toNumberArray(m_engine, value.value<QVector<qlonglong> >());
+    } else if (type == qMetaTypeId<QVector<qulonglong> >()) {
+        return toNumberArray(m_engine, value.value<QVector<qulonglong> >());
+    } else {
+        return m_engine->toScriptValue(value);
+    }
+}
+
+QJSValue DeclarativeDBusConverter::toScriptValue(
+        const QDBusArgument &argument, const SignaturePlan *plan, int index, int depth) const
+{
+    if (depth > maximumDepth) {
+        /* Skip over the value to keep the argument positioned on the next one */
+        qWarning() << "Too deep recursion detected at signature:" << plan->signature(index);
+        argument.asVariant();
+        return QJSValue();
+    }
+
+    switch (plan->node(index).kind) {
+    case SignaturePlan::Byte:
+        return QJSValue(uint(extract<uchar>(argument)));
+    case SignaturePlan::Boolean:
+        return QJSValue(extract<bool>(argument));
+    case SignaturePlan::Int16:
+        return QJSValue(int(extract<short>(argument)));
+    case SignaturePlan::UInt16:
+        return QJSValue(uint(extract<ushort>(argument)));
+    case SignaturePlan::Int32:
+        return QJSValue(extract<int>(argument));
+    case SignaturePlan::UInt32:
+        return QJSValue(extract<uint>(argument));
+    case SignaturePlan::Int64:
+        return QJSValue(double(extract<qlonglong>(argument)));
+    case SignaturePlan::UInt64:
+        return QJSValue(double(extract<qulonglong>(argument)));
+    case SignaturePlan::Double:
+        return QJSValue(extract<double>(argument));
+    case SignaturePlan::String:
+        return QJSValue(extract<QString>(argument));
+    case SignaturePlan::ObjectPath:
+        return QJSValue(extract<QDBusObjectPath>(argument).path());
+    case SignaturePlan::Signature:
+        return QJSValue(extract<QDBusSignature>(argument).signature());
+    case SignaturePlan::UnixFileDescriptor:
+        return m_engine->toScriptValue(
+                    QVariant::fromValue(extract<QDBusUnixFileDescriptor>(argument)));
+    case SignaturePlan::Variant:
+        return toScriptValue(extract<QDBusVariant>(argument).variant(), depth);
+    case SignaturePlan::ByteArray: {
+        const QByteArray bytes = extract<QByteArray>(argument);
+        if (m_options & NemoDBus::KeepByteArrays) {
+            return m_engine->toScriptValue(bytes);
+        }
+
+        QJSValue array = m_engine->newArray(bytes.size());
+        for (int i = 0; i < bytes.size(); ++i) {
+            array.setProperty(i, uint(static_cast<uchar>(bytes.at(i))));
+        }
+        return array;
+    }
+    case SignaturePlan::StringList: {
+        const QStringList strings = extract<QStringList>(argument);
+
+        QJSValue array = m_engine->newArray(strings.count());
+        for (int i = 0; i < strings.count(); ++i) {
+            array.setProperty(i, strings.at(i));
+        }
+        return array;
+    }
+    case SignaturePlan::NumericArray:
+        switch (plan->node(index + 1).kind) {
+        case SignaturePlan::Int16:
+            return toNumericArray<short>(m_engine, argument, m_options, "Int16Array");
+        case SignaturePlan::UInt16:
+            return toNumericArray<ushort>(m_engine, argument, m_options, "Uint16Array");
+        case SignaturePlan::Int32:
+            return toNumericArray<int>(m_engine, argument, m_options, "Int32Array");
+        case SignaturePlan::UInt32:
+            return toNumericArray<uint>(m_engine, argument, m_options, "Uint32Array");
+        case SignaturePlan::Int64:
+            return toNumericArray<qlonglong>(m_engine, argument, m_options, nullptr);
+        case SignaturePlan::UInt64:
+            return toNumericArray<qulonglong>(m_engine, argument, m_options, nullptr);
+        default:
+            return toNumericArray<double>(m_engine, argument, m_options, "Float64Array");
+        }
+    case SignaturePlan::Array: {
+        const int element = index + 1;
+
+        QJSValue array = m_engine->newArray();
+        argument.beginArray();
+        for (quint32 i = 0; !argument.atEnd(); ++i) {
+            array.setProperty(i, toScriptValue(argument, plan, element, depth + 1));
+        }
+        argument.endArray();
+        return array;
+    }
+    case SignaturePlan::Map: {
+        const int key = index + 1;
+        const int value = plan->nextSibling(key);
+
+        QJSValue object = m_engine->newObject();
+        argument.beginMap();
+        while (!argument.atEnd()) {
+            argument.beginMapEntry();
+            const QString name = toScriptValue(argument, plan, key, depth + 1).toString();
+            object.setProperty(name, toScriptValue(argument, plan, value, depth + 1));
+            argument.endMapEntry();
+        }
+        argument.endMap();
+        return object;
+    }
+    case SignaturePlan::Structure: {
+        const int end = plan->nextSibling(index);
+
+        QJSValue array = m_engine->newArray();
+        argument.beginStructure();
+        quint32 i = 0;
+        for (int field = index + 1; field < end; field = plan->nextSibling(field)) {
+            array.setProperty(i++, toScriptValue(argument, plan, field, depth + 1));
+        }
+        argument.endStructure();
+        return array;
+    }
+    }
+
+    return QJSValue();
+}
+
+/* Converts a script value to a D-Bus argument with the type of a plan.
+ * Basic types and the containers QtDBus has types of its own for are
+ * returned as those, anything else is written to a QDBusArgument by
+ * walking the plan. */
+QVariant DeclarativeDBusConverter::fromScriptValue(
+        const QJSValue &value, const SignaturePlan *plan, int depth)
+{
+    const SignaturePlan::Kind kind = plan->node(0).kind;
+
+    if (SignaturePlan::isBasic(kind)) {
+        return toBasicArgument(kind, value);
+    } else if (kind == SignaturePlan::Variant) {
+        const QVariant variant = fromScriptValue(value, depth + 1);
+        return variant.isValid() ? QVariant::fromValue(QDBusVariant(variant)) : QVariant();
+    }
+
+    /* ArrayBuffers and typed arrays are accepted wherever arrays are, the
+     * bytes of the ones matching the element type are used as they are */
+    QByteArray bytes;
+    const QString binaryType = binaryData(value, &bytes);
+
+    if (kind != SignaturePlan::Map && !value.isArray() && binaryType.isEmpty()) {
+        return QVariant();
+    } else if (kind != SignaturePlan::ByteArray && isBufferData(binaryType)) {
+        return QVariant();
+    }
+
+    QVariant argument;
+    switch (kind) {
+    case SignaturePlan::ByteArray:
+        return isByteData(binaryType) ? bytes : toByteArray(value);
+    case SignaturePlan::StringList:
+        return toStringList(value);
+    case SignaturePlan::NumericArray:
+        if (!binaryType.isEmpty() && binaryType == typedArrayName(plan->node(1).kind)) {
+            return fromBinaryData(binaryType, bytes);
+        } else if (flattenNumericArray(argument, value, plan->signature(1).at(0))) {
+            return argument;
+        }
+        break;
+    default:
+        break;
+    }
+
+    QDBusArgument dbusArgument;
+    if (marshall(dbusArgument, value, plan, 0, depth)) {
+        argument = QVariant::fromValue(dbusArgument);
+    }
+    return argument;
+}
+
+/* Converts a script value to the content of a variant, with the type
+ * guessed from the value. */
+QVariant DeclarativeDBusConverter::fromScriptValue(const QJSValue &value, int depth)
+{
+    if (depth > maximumDepth) {
+        qWarning() << "Too deep recursion detected converting a script value";
+        return QVariant();
+    }
+
+    if (value.isObject() && !value.isArray()) {
+        const QVariant binary = fromBinaryValue(value);
+        if (binary.isValid()) {
+            return binary;
+        }
+    }
+
+    return value.isArray() ? guessArray(value) : value.toVariant();
+}
+
+/* Converts an ArrayBuffer or a typed array to a byte array or to a list
+ * of numbers of the element type, anything else to an invalid variant. */
+QVariant DeclarativeDBusConverter::fromBinaryValue(const QJSValue &value)
+{
+    QByteArray bytes;
+    const QString binaryType = binaryData(value, &bytes);
+    return binaryType.isEmpty() ? QVariant() : fromBinaryData(binaryType, bytes);
+}
+
+bool DeclarativeDBusConverter::marshall(
+        QDBusArgument &argument,
+        const QJSValue &value,
+        const SignaturePlan *plan,
+        int index,
+        int depth)
+{
+    if (depth > maximumDepth) {
+        qWarning() << "Too deep recursion detected at signature:" << plan->signature(index);
+        return false;
+    }
+
+    const SignaturePlan::Kind kind = plan->node(index).kind;
+
+    if (SignaturePlan::isBasic(kind)) {
+        marshallBasic(argument, kind, value);
+        return true;
+    } else if (kind == SignaturePlan::Variant) {
+        const QVariant variant = fromScriptValue(value, depth + 1);
+        if (!variant.isValid()) {
+            return false;
+        }
+        argument << QDBusVariant(variant);
+        return true;
+    }
+
+    QByteArray bytes;
+    const QString binaryType = kind != SignaturePlan::Map && kind != SignaturePlan::Structure
+            ? binaryData(value, &bytes)
+            : QString();
+
+    if (kind == SignaturePlan::Map ? !value.isObject() : (!value.isArray() && binaryType.isEmpty())) {
+        qWarning() << "Invalid value for type specifier:" << plan->signature(index)
+                   << "v:" << value.toVariant();
+        return false;
+    } else if (kind != SignaturePlan::ByteArray && isBufferData(binaryType)) {
+        qWarning() << "Invalid value for type specifier:" << plan->signature(index)
+                   << "v:" << binaryType;
+        return false;
+    }
+
+    if (kind == SignaturePlan::NumericArray
+            && !binaryType.isEmpty()
+            && binaryType == typedArrayName(plan->node(index + 1).kind)) {
+        switch (plan->node(index + 1).kind) {
+        case SignaturePlan::Int16:
+            marshallBinaryData<qint16>(argument, bytes);
+            break;
+        case SignaturePlan::UInt16:
+            marshallBinaryData<quint16>(argument, bytes);
+            break;
+        case SignaturePlan::Int32:
+            marshallBinaryData<qint32>(argument, bytes);
+            break;
+        case SignaturePlan::UInt32:
+            marshallBinaryData<quint32>(argument, bytes);
+            break;
+        default:
+            marshallBinaryData<double>(argument, bytes);
+            break;
+        }
+        return true;
+    }
+
+    switch (kind) {
+    case SignaturePlan::ByteArray:
+        argument << (isByteData(binaryType) ? bytes : toByteArray(value));
+        return true;
+    case SignaturePlan::StringList:
+        argument << toStringList(value);
+        return true;
+    case SignaturePlan::NumericArray:
+    case SignaturePlan::Array: {
+        const int element = index + 1;
+        const int elementType = plan->metaType(element);
+        if (elementType == QMetaType::UnknownType) {
+            return false;
+        }
+
+        const quint32 length = value.property(QLatin1String("length")).toUInt();
+
+        argument.beginArray(elementType);
+        for (quint32 i = 0; i < length; ++i) {
+            if (!marshall(argument, value.property(i), plan, element, depth + 1)) {
+                return false;
+            }
+        }
+        argument.endArray();
+        return true;
+    }
+    case SignaturePlan::Map: {
+        const int key = index + 1;
+        const int entry = plan->nextSibling(key);
+        const int keyType = plan->metaType(key);
+        const int entryType = plan->metaType(entry);
+        if (keyType == QMetaType::UnknownType || entryType == QMetaType::UnknownType) {
+            return false;
+        }
+
+        argument.beginMap(keyType, entryType);
+        QJSValueIterator it(value);
+        while (it.hasNext()) {
+            it.next();
+            argument.beginMapEntry();
+            if (plan->node(key).kind == SignaturePlan::String) {
+                argument << it.name();
+            } else {
+                marshallBasic(argument, plan->node(key).kind, QJSValue(it.name()));
+            }
+            if (!marshall(argument, it.value(), plan, entry, depth + 1)) {
+                return false;
+            }
+            argument.endMapEntry();
+        }
+        argument.endMap();
+        return true;
+    }
+    case SignaturePlan::Structure: {
+        if (value.property(QLatin1String("length")).toUInt() != quint32(plan->fieldCount(index))) {
+            qWarning() << "Invalid value for type specifier:" << plan->signature(index)
+                       << "v:" << value.toVariant();
+            return false;
+        }
+
+        argument.beginStructure();
+        quint32 i = 0;
+        for (int field = index + 1; field < plan->nextSibling(index); field = plan->nextSibling(field)) {
+            if (!marshall(argument, value.property(i++), plan, field, depth + 1)) {
+                return false;
+            }
+        }
+        argument.endStructure();
+        return true;
+    }
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,71 @@
+/****************************************************************************************
+**
+** Copyright (C) 2026 Jolla Ltd.
+** All rights reserved.
+**
+** You may use this file under the terms of the GNU Lesser General
+** Public License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+** Lesser General Public License for more details.
+**
+****************************************************************************************/
+
+#ifndef DECLARATIVEDBUSCONVERTER_H
+#define DECLARATIVEDBUSCONVERTER_H
+
+#include <QDBusArgument>
+#include <QJSValue>
+#include <QVariant>
+
+#include "dbus.h"
+
+QT_BEGIN_NAMESPACE
+class QJSEngine;
+QT_END_NAMESPACE
+
+namespace NemoDBus {
+class SignaturePlan;
+}
+
+class DeclarativeDBusConverter
+{
+public:
+    DeclarativeDBusConverter(QJSEngine *engine, NemoDBus::DemarshallOptions options);
+
+    QJSValue toScriptValue(const QVariant &argument, int depth = 0) const;
+    QJSValue fromVariant(const QVariant &value) const;
+
+    static QVariant fromScriptValue(
+            const QJSValue &value, const NemoDBus::SignaturePlan *plan, int depth = 0);
+    static QVariant fromScriptValue(const QJSValue &value, int depth = 0);
+    static QVariant fromBinaryValue(const QJSValue &value);
+
+private:
+    QJSValue toScriptValue(
+            const QDBusArgument &argument,
+            const NemoDBus::SignaturePlan *plan,
+            int index,
+            int depth) const;
+    static bool marshall(
+            QDBusArgument &argument,
+            const QJSValue &value,
+            const NemoDBus::SignaturePlan *plan,
+            int index,
+            int depth);
+
+    QJSEngine * const m_engine;
+    const NemoDBus::DemarshallOptions m_options;
+};
+
+#endif
@@ -23,8 +23,15 @@
 ****************************************************************************************/
 
 #include "declarativedbusinterface.h"
+#include "declarativedbusconverter.h"
+#include "declarativedbuslazyvalue.h"
+#include "declarativedbuspendingcall.h"
 #include "dbus.h"
 
+#include "private/replycache.h"
+#include "private/signatureplan.h"
+#include "private/stringpool.h"
+
 #include <QMetaMethod>
 #include <QDBusMessage>
 #include <QDBusConnection>
@@ -37,8 +44,10 @@
 #include <qqmlinfo.h>
 #include <QJSEngine>
 #include <QJSValue>
-#include <QJSValueIterator>
 #include <QFile>
+#include <QFutureInterface>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QUrl>
 #include <QXmlStreamReader>
 
@@ -157,6 +166,123 @@
 
 namespace {
 const QLatin1String PropertyInterface("org.freedesktop.DBus.Properties");
+
+bool arrayBuffersEnabledByDefault()
+{
+    static const bool enabled = qEnvironmentVariableIntValue("NEMO_DBUS_ARRAY_BUFFERS") > 0;
+    return enabled;
+}
+
+int threadedDecodingThresholdByDefault()
+{
+    static const int threshold = qMax(
+                0, qEnvironmentVariableIntValue("NEMO_DBUS_THREADED_DECODING_THRESHOLD"));
+    return threshold;
+}
+
+/* Counts the values in an argument, giving up once the limit is
+ * reached. The argument is a copy and is detached from the message
+ * on the first read, so the original is left as it was. */
+int countValues(const QDBusArgument &argument, int limit)
+{
+    int count = 0;
+
+    while (count < limit && !argument.atEnd()) {
+        ++count;
+
+        switch (argument.currentType()) {
+        case QDBusArgument::ArrayType:
+            argument.beginArray();
+            count += countValues(argument, limit - count);
+            argument.endArray();
+            break;
+        case QDBusArgument::MapType:
+            argument.beginMap();
+            count += countValues(argument, limit - count);
+            argument.endMap();
+            break;
+        case QDBusArgument::MapEntryType:
+            argument.beginMapEntry();
+            count += countValues(argument, limit - count);
+            argument.endMapEntry();
+            break;
+        case QDBusArgument::StructureType:
+            argument.beginStructure();
+            count += countValues(argument, limit - count);
+            argument.endStructure();
+            break;
+        default: {
+            const QVariant value = argument.asVariant();
+            if (value.userType() == qMetaTypeId<QDBusVariant>()) {
+                const QVariant content = value.value<QDBusVariant>().variant();
+                if (content.userType() == qMetaTypeId<QDBusArgument>()) {
+                    count += countValues(content.value<QDBusArgument>(), limit - count);
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    return count;
+}
+
+int countValues(const QVariantList &arguments, int limit)
+{
+    int count = 0;
+
+    foreach (const QVariant &argument, arguments) {
+        if (count >= limit) {
+            break;
+        }
+
+        const int type = argument.userType();
+        if (type == qMetaTypeId<QDBusArgument>()) {
+            count += countValues(argument.value<QDBusArgument>(), limit - count);
+        } else if (type == QMetaType::QByteArray) {
+            count += argument.toByteArray().size();
+        } else if (type == QMetaType::QStringList) {
+            count += argument.toStringList().count();
+        } else {
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+class DecodingTask : public QRunnable
+{
+public:
+    DecodingTask(const QVariantList &arguments, NemoDBus::DemarshallOptions options)
+        : m_arguments(arguments)
+        , m_options(options)
+    {
+        m_result.reportStarted();
+    }
+
+    QFuture<QVariantList> future()
+    {
+        return m_result.future();
+    }
+
+    void run()
+    {
+        QVariantList decoded;
+        decoded.reserve(m_arguments.count());
+        foreach (const QVariant &argument, m_arguments) {
+            decoded.append(NemoDBus::demarshallDBusArgument(argument, m_options));
+        }
+
+        m_result.reportResult(decoded);
+        m_result.reportFinished();
+    }
+
+private:
+    const QVariantList m_arguments;
+    const NemoDBus::DemarshallOptions m_options;
+    QFutureInterface<QVariantList> m_result;
+};
 }
 
 DeclarativeDBusInterface::DeclarativeDBusInterface(QObject *parent)
@@ -171,6 +297,11 @@ DeclarativeDBusInterface::DeclarativeDBusInterface(QObject *parent)
     , m_propertiesConnected(false)
     , m_introspected(false)
     , m_providesPropertyInterface(false)
+    , m_arrayBuffersEnabled(arrayBuffersEnabledByDefault())
+    , m_lazyRepliesEnabled(false)
+    , m_threadedDecodingThreshold(threadedDecodingThresholdByDefault())
+    , m_methodSignaturesEnabled(false)
+    , m_timeout(0)
     , m_serviceWatcher(nullptr)
 {
 }
@@ -178,6 +309,9 @@ DeclarativeDBusInterface::DeclarativeDBusInterface(QObject *parent)
 DeclarativeDBusInterface::~DeclarativeDBusInterface()
 {
     qDeleteAll(m_pendingCalls.keys());
+    for (const Delivery &delivery : m_deliveries) {
+        delete delivery.call;
+    }
 }
 
 /*!
@@ -373,185 +507,364 @@ void DeclarativeDBusInterface::setPropertiesEnabled(bool enabled)
     }
 }
 
+/*!
+    \qmlproperty bool DBusInterface::arrayBuffersEnabled
+
+    This property holds whether D-Bus byte arrays (signature \c ay) in method replies, signal
+    arguments and property values are delivered as \c ArrayBuffer objects. The buffer shares
+    the data received from D-Bus, so large payloads are not copied into an array of numbers.
+
+    Arrays of 16 and 32 bit integers and doubles are delivered as the matching typed arrays,
+    for example \c Int32Array for \c ai and \c Float64Array for \c ad. Arrays of 64 bit
+    integers remain arrays of numbers. Tracked properties receive these values only if they
+    are declared as \c var.
+
+    When disabled, byte and numeric arrays are delivered as arrays of numbers. The default is \c false,
+    unless the \c NEMO_DBUS_ARRAY_BUFFERS environment variable is set to \c 1.
+
+    \since version 2.1.25
+*/
+
+bool DeclarativeDBusInterface::arrayBuffersEnabled() const
+{
+    return m_arrayBuffersEnabled;
+}
+
+void DeclarativeDBusInterface::setArrayBuffersEnabled(bool enabled)
+{
+    if (m_arrayBuffersEnabled != enabled) {
+        m_arrayBuffersEnabled = enabled;
+        emit arrayBuffersEnabledChanged();
+    }
+}
+
+/*!
+    \qmlproperty bool DBusInterface::lazyRepliesEnabled
+
+    This property holds whether arrays, dictionaries and structures in method replies are
+    passed to the callback as \l DBusLazyValue objects which decode their elements only when
+    accessed. This makes large replies cheap to receive when the callback only looks at a few
+    of the elements.
+
+    The default is \c false.
+
+    \since version 2.1.25
+*/
+
+bool DeclarativeDBusInterface::lazyRepliesEnabled() const
+{
+    return m_lazyRepliesEnabled;
+}
+
+void DeclarativeDBusInterface::setLazyRepliesEnabled(bool enabled)
+{
+    if (m_lazyRepliesEnabled != enabled) {
+        m_lazyRepliesEnabled = enabled;
+        emit lazyRepliesEnabledChanged();
+    }
+}
+
+/*!
+    \qmlproperty int DBusInterface::threadedDecodingThreshold
+
+    This property holds the number of values from which on the arguments of method replies,
+    signals and property changes are decoded on a worker thread instead of the GUI thread.
+    Every basic value, byte and string array element and container counts as one value.
+
+    Callbacks, signal handlers and property updates are still invoked on the GUI thread and
+    in the order the messages were received, a small message received after a large one is
+    delivered only after the large one has been decoded. Replies passed as lazy values (see
+    \l lazyRepliesEnabled), and property values while \l arrayBuffersEnabled is set, are not
+    decoded on worker threads.
+
+    The default is \c 0 which disables decoding on worker threads, unless the
+    \c NEMO_DBUS_THREADED_DECODING_THRESHOLD environment variable gives another value.
+
+    \since version 2.1.25
+*/
+
+int DeclarativeDBusInterface::threadedDecodingThreshold() const
+{
+    return m_threadedDecodingThreshold;
+}
+
+void DeclarativeDBusInterface::setThreadedDecodingThreshold(int threshold)
+{
+    threshold = qMax(0, threshold);
+    if (m_threadedDecodingThreshold != threshold) {
+        m_threadedDecodingThreshold = threshold;
+        emit threadedDecodingThresholdChanged();
+    }
+}
+
+/*!
+    \qmlproperty bool DBusInterface::methodSignaturesEnabled
+
+    This property holds whether \l call() marshals arguments with the types the introspection
+    data of the interface declares for the method, instead of guessing the types from the
+    values. This gives the same results as \l typedCall() without describing the type of each
+    argument.
+
+    The interface is introspected once when this is enabled. Arguments of calls made before
+    the introspection data is available, of methods the interface doesn't declare and of calls
+    whose arguments don't fit the declared types have their types guessed as before.
+
+    The default is \c false.
+
+    \since version 2.1.25
+*/
+
+bool DeclarativeDBusInterface::methodSignaturesEnabled() const
+{
+    return m_methodSignaturesEnabled;
+}
+
+void DeclarativeDBusInterface::setMethodSignaturesEnabled(bool enabled)
+{
+    if (m_methodSignaturesEnabled != enabled) {
+        m_methodSignaturesEnabled = enabled;
+        emit methodSignaturesEnabledChanged();
+
+        introspectMethodSignatures();
+    }
+}
+
+/*!
+    \qmlproperty int DBusInterface::timeout
+
+    This property holds the number of milliseconds to wait for the reply to a method call
+    before the error callback is called with a timeout error. A call can override this with
+    the \c timeout argument of \l call() and \l typedCall().
+
+    The default is \c 0 which waits for as long as the D-Bus default of 25 seconds.
+
+    \since version 2.1.25
+*/
+
+int DeclarativeDBusInterface::timeout() const
+{
+    return m_timeout;
+}
+
+void DeclarativeDBusInterface::setTimeout(int timeout)
+{
+    timeout = qMax(0, timeout);
+    if (m_timeout != timeout) {
+        m_timeout = timeout;
+        emit timeoutChanged();
+    }
+}
+
+NemoDBus::DemarshallOptions DeclarativeDBusInterface::demarshallOptions() const
+{
+    return m_arrayBuffersEnabled
+            ? NemoDBus::KeepByteArrays | NemoDBus::PackNumericArrays
+            : NemoDBus::DefaultDemarshalling;
+}
+
+bool DeclarativeDBusInterface::propertiesThreadable() const
+{
+    // Worker threads decode with demarshallOptions(), which with array buffers enabled would
+    // hand byte and numeric arrays packed to typed properties. Typed properties take the plain
+    // values and var properties the script values, both of which are decoded on the GUI thread.
+    return !m_arrayBuffersEnabled;
+}
+
+QVariant DeclarativeDBusInterface::demarshall(const QVariant &argument, bool decoded) const
+{
+    // Typed arrays only exist as script values, convert to one directly.
+    QJSEngine *engine = m_arrayBuffersEnabled ? qjsEngine(this) : nullptr;
+    if (engine) {
+        const DeclarativeDBusConverter converter(engine, demarshallOptions());
+        return QVariant::fromValue(decoded
+                ? converter.fromVariant(argument)
+                : converter.toScriptValue(argument));
+    }
+    return decoded ? argument : NemoDBus::demarshallDBusArgument(argument, demarshallOptions());
+}
+
+void DeclarativeDBusInterface::deliver(
+        const QDBusMessage &message,
+        bool threadable,
+        const DeliveryHandler &handler,
+        QDBusPendingCallWatcher *call)
+{
+    const QVariantList arguments = message.arguments();
+
+    const bool threaded = threadable
+            && m_threadedDecodingThreshold > 0
+            && countValues(arguments, m_threadedDecodingThreshold) >= m_threadedDecodingThreshold;
+
+    if (!threaded && m_deliveries.isEmpty()) {
+        if (call) {
+            call->deleteLater();
+        }
+        handler(arguments, false);
+        return;
+    }
+
+    // The watcher of a call is kept until its reply is delivered, so that the call can still be
+    // cancelled while the reply waits in the queue.
+    Delivery delivery;
+    delivery.call = call;
+    delivery.cancelled = false;
+    delivery.watcher = nullptr;
+    delivery.arguments = arguments;
+    delivery.handler = handler;
+
+    if (threaded) {
+        DecodingTask *task = new DecodingTask(arguments, demarshallOptions());
+
+        delivery.watcher = new QFutureWatcher<QVariantList>(this);
+        connect(delivery.watcher, &QFutureWatcherBase::finished,
+                this, &DeclarativeDBusInterface::decodingFinished);
+        delivery.watcher->setFuture(task->future());
+
+        QThreadPool::globalInstance()->start(task);
+    }
+
+    m_deliveries.append(delivery);
+}
+
+void DeclarativeDBusInterface::decodingFinished()
+{
+    QPointer<DeclarativeDBusInterface> guard(this);
+
+    // Deliver in order up to the first message which is still being decoded.
+    while (guard && !m_deliveries.isEmpty()) {
+        QFutureWatcher<QVariantList> *watcher = m_deliveries.first().watcher;
+        if (watcher && !watcher->isFinished()) {
+            break;
+        }
+
+        Delivery delivery = m_deliveries.takeFirst();
+        if (delivery.call) {
+            delivery.call->deleteLater();
+        }
+        if (watcher) {
+            delivery.arguments = watcher->result();
+            watcher->deleteLater();
+        }
+
+        if (!delivery.cancelled) {
+            delivery.handler(delivery.arguments, watcher != nullptr);
+        }
+    }
+}
+
+static QVariant argumentFromScriptValue(const QJSValue &value)
+{
+    // ArrayBuffers and typed arrays are passed as byte and numeric arrays.
+    const QVariant binary = DeclarativeDBusConverter::fromBinaryValue(value);
+    return binary.isValid() ? binary : value.toVariant();
+}
+
 QVariantList DeclarativeDBusInterface::argumentsFromScriptValue(const QJSValue &arguments)
 {
     QVariantList dbusArguments;
 
     if (arguments.isArray()) {
-        QJSValueIterator it(arguments);
-        while (it.hasNext()) {
-            it.next();
-            // Arrays carry the size as last value
-            if (!it.hasNext())
-                continue;
-            dbusArguments.append(it.value().toVariant());
+        const quint32 length = arguments.property(QLatin1String("length")).toUInt();
+        dbusArguments.reserve(length);
+        for (quint32 i = 0; i < length; ++i) {
+            dbusArguments.append(argumentFromScriptValue(arguments.property(i)));
         }
     } else if (!arguments.isUndefined()) {
-        dbusArguments.append(arguments.toVariant());
+        dbusArguments.append(argumentFromScriptValue(arguments));
     }
 
     return dbusArguments;
 }
 
 /*!
-    \qmlmethod void DBusInterface::call(string method, var arguments, var callback, var errorCallback)
+    \qmlmethod DBusPendingCall DBusInterface::call(string method, var arguments, var callback, var errorCallback, int timeout)
 
     Call a D-Bus method with the name \a method on the object with \a arguments as either a single
     value or an array. For a function with no arguments, pass in \c undefined.
 
-    The callback arguments are handled as described under \l typedCall().
+    The callback and \a timeout arguments are handled as described under \l typedCall().
+
+    If a \a callback is given a \l DBusPendingCall is returned through which the call can be
+    cancelled, otherwise \c null is returned.
 
     \note This function supports passing basic data types and will fail if the signature of the
           remote method does not match the signature determined from the type of \a arguments. The
           \l typedCall() function can be used to explicity specify the type of each element of
-          \a arguments.
+          \a arguments, or \l methodSignaturesEnabled set to take the types from the
+          introspection data of the interface.
 */
-void DeclarativeDBusInterface::call(
+QJSValue DeclarativeDBusInterface::call(
         const QString &method,
         const QJSValue &arguments,
         const QJSValue &callback,
-        const QJSValue &errorCallback)
+        const QJSValue &errorCallback,
+        int timeout)
 {
-    QVariantList dbusArguments = argumentsFromScriptValue(arguments);
-
     QDBusMessage message = QDBusMessage::createMethodCall(
                 m_service,
                 m_path,
                 m_interface,
                 method);
-    message.setArguments(dbusArguments);
 
-    dispatch(message, callback, errorCallback);
-}
-
-template<typename T> static QList<T> toQList(const QVariantList &lst)
-{
-    QList<T> arr;
-    foreach (const QVariant &var, lst) {
-        arr << qvariant_cast<T>(var);
+    if (!m_methodSignaturesEnabled || !coerceArguments(message, arguments)) {
+        message.setArguments(argumentsFromScriptValue(arguments));
     }
-    return arr;
-}
 
-static QStringList toQStringList(const QVariantList &lst)
-{
-    QStringList arr;
-    foreach (const QVariant &var, lst) {
-        arr << qvariant_cast<QString>(var);
-    }
-    return arr;
+    QDBusPendingCallWatcher *watcher = nullptr;
+    dispatch(message, callback, errorCallback, timeout, &watcher);
+
+    QJSEngine *engine = watcher ? qjsEngine(this) : nullptr;
+    return engine
+            ? engine->newQObject(new DeclarativeDBusPendingCall(this, watcher))
+            : QJSValue(QJSValue::NullValue);
 }
 
-static QByteArray toQByteArray(const QVariantList &lst)
+bool DeclarativeDBusInterface::coerceArguments(QDBusMessage &message, const QJSValue &arguments)
 {
-    QByteArray arr;
-    foreach (const QVariant &var, lst) {
-        uchar tmp = static_cast<uchar>(var.toUInt());
-        arr.append(static_cast<char>(tmp));
+    introspectMethodSignatures();
+
+    const auto it = m_methodSignatures.constFind(message.member());
+    if (it == m_methodSignatures.constEnd()) {
+        return false;
     }
-    return arr;
-}
 
-static bool flattenVariantList(QVariant &var, const QVariantList &lst,
-                               int typeChar)
-{
-    bool res = true;
+    const QVector<QSharedPointer<const NemoDBus::SignaturePlan> > &plans = *it;
+
+    QJSValueList values;
+    if (arguments.isArray()) {
+        const quint32 length = arguments.property(QLatin1String("length")).toUInt();
+        for (quint32 i = 0; i < length; ++i) {
+            values.append(arguments.property(i));
+        }
+    } else if (!arguments.isUndefined()) {
+        values.append(arguments);
+    }
 
-    switch (typeChar) {
-    case 'b': // BOOLEAN
-        var = QVariant::fromValue(toQList<bool>(lst));
-        break;
-    case 'y': // BYTE
-        var = QVariant::fromValue(toQByteArray(lst));
-        break;
-    case 'q': // UINT16
-        var = QVariant::fromValue(toQList<quint16>(lst));
-        break;
-    case 'u': // UINT32
-        var = QVariant::fromValue(toQList<quint32>(lst));
-        break;
-    case 't': // UINT64
-        var = QVariant::fromValue(toQList<quint64>(lst));
-        break;
-    case 'n': // INT16
-        var = QVariant::fromValue(toQList<qint16>(lst));
-        break;
-    case 'i': // INT32
-        var = QVariant::fromValue(toQList<qint32>(lst));
-        break;
-    case 'x': // INT64
-        var = QVariant::fromValue(toQList<qint64>(lst));
-        break;
-    case 'd': // DOUBLE
-        var = QVariant::fromValue(toQList<double>(lst));
-        break;
-    case 's': // STRING
-        var = QVariant::fromValue(toQStringList(lst));
-        break;
-    default:
-        res = false;
-        break;
+    if (values.count() != plans.count()) {
+        return false;
     }
 
-    return res;
-}
+    QVariantList dbusArguments;
+    dbusArguments.reserve(plans.count());
+    for (int i = 0; i < plans.count(); ++i) {
+        const QVariant argument = DeclarativeDBusConverter::fromScriptValue(
+                    values.at(i), plans.at(i).data());
+        if (!argument.isValid()) {
+            return false;
+        }
+        dbusArguments.append(argument);
+    }
 
-static bool flattenVariantArrayForceType(QVariant &var, int typeChar)
-{
-    return flattenVariantList(var, var.toList(), typeChar);
+    message.setArguments(dbusArguments);
+    return true;
 }
 
-static void flattenVariantArrayGuessType(QVariant &var)
+static bool isTypedValue(const QJSValue &value)
 {
-    /* If the value can't be converted to a variant list
-     * or if the resulting list would be empty: use the
-     * value without modification */
-    QVariantList arr = var.toList();
-    if (arr.empty())
-        return;
-
-    /* If all items in the list do not share the same type:
-     * use as is -> each value will be wrapped in variant
-     * container */
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-    int t = arr[0].typeId();
-#else
-    int t = arr[0].type();
-#endif
-    int n = arr.size();
-    for (int i = 1; i < n; ++i) {
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-        if (arr[i].typeId() != t)
-#else
-        if (arr[i].type() != t)
-#endif
-            return;
-    }
-
-    switch (t) {
-    case QVariant::String:
-        flattenVariantList(var, arr, 's');
-        break;
-    case QVariant::Bool:
-        flattenVariantList(var, arr, 'b');
-        break;
-    case QVariant::Int:
-        flattenVariantList(var, arr, 'i');
-        break;
-    case QVariant::Double:
-        flattenVariantList(var, arr, 'd');
-        break;
-    default:
-        /* Unhandled types are encoded as variant:array:variant:val
-         * instead of variant:array:val what we actually want.
-         */
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-        qWarning("unhandled array type: %d (%s)", t, QMetaType(t).name());
-#else
-        qWarning("unhandled array type: %d (%s)", t, QVariant::typeToName(t));
-#endif
-        break;
-    }
+    return value.isObject()
+            && !value.isArray()
+            && value.property(QLatin1String("type")).isString()
+            && value.hasOwnProperty(QLatin1String("value"));
 }
 
 bool
@@ -573,108 +886,46 @@ DeclarativeDBusInterface::marshallDBusArgument(QDBusMessage &msg, const QJSValue
         return false;
     }
 
+    // Signatures are compiled once and shared by every call using them.
     QString t = type.toString();
-    if (t.length() == 1) {
-        switch (t.at(0).toLatin1()) {
-        case 'y': // BYTE
-            msg << QVariant::fromValue(static_cast<quint8>(value.toUInt()));
-            return true;
-
-        case 'q': // UINT16
-            msg << QVariant::fromValue(static_cast<quint16>(value.toUInt()));
-            return true;
-
-        case 'u': // UINT32
-            msg << QVariant::fromValue(static_cast<quint32>(value.toUInt()));
-            return true;
-
-        case 't': // UINT64
-            msg << QVariant::fromValue(static_cast<quint64>(value.toVariant().toULongLong()));
-            return true;
-
-        case 'n': // INT16
-            msg << QVariant::fromValue(static_cast<qint16>(value.toInt()));
-            return true;
-
-        case 'i': // INT32
-            msg << QVariant::fromValue(static_cast<qint32>(value.toInt()));
-            return true;
-
-        case 'x': // INT64
-            msg << QVariant::fromValue(static_cast<qint64>(value.toVariant().toLongLong()));
-            return true;
-
-        case 'b': // BOOLEAN
-            msg << value.toBool();
-            return true;
-
-        case 'd': // DOUBLE
-            msg << value.toNumber();
-            return true;
-
-        case 's': // STRING
-            msg << value.toString();
-            return true;
-
-        case 'o': // OBJECT_PATH
-            msg << QVariant::fromValue(QDBusObjectPath(value.toString()));
-            return true;
-
-        case 'g': // SIGNATURE
-            msg << QVariant::fromValue(QDBusSignature(value.toString()));
-            return true;
-
-        case 'h': // UNIX_FD
-            msg << QVariant::fromValue(QDBusUnixFileDescriptor(value.toInt()));
-            return true;
-
-        case 'v': { // VARIANT
-            QVariant var = value.toVariant();
-            flattenVariantArrayGuessType(var);
-            msg << QVariant::fromValue(QDBusVariant(var));
-        }
-            return true;
+    const QSharedPointer<const NemoDBus::SignaturePlan> plan
+            = NemoDBus::SignaturePlan::fromSignature(t);
+    if (!plan) {
+        qWarning() << "DeclarativeDBusInterface::typedCall - Invalid type specifier:" << t;
+        qmlInfo(this) << "DeclarativeDBusInterface::typedCall - Invalid type specifier: " << t;
+        return false;
+    }
 
-        default:
-            break;
-        }
-    } else if (t.length() == 2 && (t.at(0).toLatin1() == 'a')) {
-        // The result must be an array of typed data
-        if (!value.isArray()) {
-            qWarning() << "Invalid value for type specifier:" << t << "v:" << value.toVariant();
-            qmlInfo(this) << "Invalid value for type specifier: " << t << " v: " << value.toVariant();
+    QVariant argument;
+    if (plan->node(0).kind == NemoDBus::SignaturePlan::Variant && isTypedValue(value)) {
+        // The value of a variant argument can be typed the same way, for contents whose type
+        // can't be guessed. Only the argument itself is, values nested in containers never are.
+        const QString contentType = value.property(QLatin1String("type")).toString();
+        const QSharedPointer<const NemoDBus::SignaturePlan> contentPlan
+                = NemoDBus::SignaturePlan::fromSignature(contentType);
+        if (!contentPlan) {
+            qWarning() << "DeclarativeDBusInterface::typedCall - Invalid type specifier:" << contentType;
+            qmlInfo(this) << "DeclarativeDBusInterface::typedCall - Invalid type specifier: " << contentType;
             return false;
         }
 
-        QVariant vec = value.toVariant();
-        int type = t.at(1).toLatin1();
-
-        if (flattenVariantArrayForceType(vec, type)) {
-            msg << vec;
-            return true;
-        }
-    } else if (t == "a{sv}") {
-        if (!value.isObject()) {
-            qWarning() << "Invalid value for type specifier:" << t << "v:" << value.toVariant();
-            qmlInfo(this) << "Invalid value for type specifier: " << t << " v: " << value.toVariant();
-            return false;
-        }
-        QVariantMap variantMap;
-        QJSValueIterator it(value);
-        while (it.hasNext()) {
-            it.next();
-            QVariant var = it.value().toVariant();
-            flattenVariantArrayGuessType(var);
-            variantMap.insert(it.name(), var);
+        const QVariant content = DeclarativeDBusConverter::fromScriptValue(
+                    value.property(QLatin1String("value")), contentPlan.data());
+        if (content.isValid()) {
+            argument = QVariant::fromValue(QDBusVariant(content));
         }
+    } else {
+        argument = DeclarativeDBusConverter::fromScriptValue(value, plan.data());
+    }
 
-        msg << variantMap;
-        return true;
+    if (!argument.isValid()) {
+        qWarning() << "Invalid value for type specifier:" << t << "v:" << value.toVariant();
+        qmlInfo(this) << "Invalid value for type specifier: " << t << " v: " << value.toVariant();
+        return false;
     }
 
-    qWarning() << "DeclarativeDBusInterface::typedCall - Invalid type specifier:" << t;
-    qmlInfo(this) << "DeclarativeDBusInterface::typedCall - Invalid type specifier: " << t;
-    return false;
+    msg << argument;
+    return true;
 }
 
 QDBusMessage
@@ -728,7 +979,7 @@ bool DeclarativeDBusInterface::serviceAvailable() const
 }
 
 /*!
-    \qmlmethod bool DBusInterface::typedCall(string method, var arguments, var callback, var errorCallback)
+    \qmlmethod bool DBusInterface::typedCall(string method, var arguments, var callback, var errorCallback, int timeout)
 
     Call a D-Bus method with the name \a method on the object with \a arguments. Each parameter is
     described by an object:
@@ -743,6 +994,17 @@ bool DeclarativeDBusInterface::serviceAvailable() const
     Where \c type is the D-Bus type that \c value should be marshalled as. \a arguments can be
     either a single object describing the parameter or an array of objects.
 
+    Any complete D-Bus type can be given. Structures are passed as arrays with a value for each
+    field and dicts as objects, so \c{a(ii)} takes a value like \c{[[1, 2], [3, 4]]}. Values
+    of variants have their type guessed from the value. The value of an argument of type \c v
+    can itself be an object with a \c type and a \c value property, which is then marshalled
+    as that type, such as \c{{"type": "v", "value": {"type": "a(su)", "value": [["a", 1]]}}}.
+    Objects nested in other values are always marshalled as dicts.
+
+    An \c ArrayBuffer or a typed array can be given for any array type. Its bytes are used as
+    they are for \c ay and for numeric arrays of the typed array's element type, such as an
+    \c Int32Array for \c ai, without converting each element.
+
     A method with the D-Bus signature \c{ssa{sv}}, so two string parameters and an array of dict
     can be called like this:
 
@@ -764,10 +1026,14 @@ bool DeclarativeDBusInterface::serviceAvailable() const
     Both callback arguments are optional, if set to \c undefined (the default),
     the return value and/or error messages will be discarded.
 
+    If no reply is received within \a timeout milliseconds \a errorCallback is called with
+    the \c org.freedesktop.DBus.Error.NoReply error. If \a timeout is omitted or \c 0 the
+    \l timeout property applies.
 */
 bool DeclarativeDBusInterface::typedCall(const QString &method, const QJSValue &arguments,
                                          const QJSValue &callback,
-                                         const QJSValue &errorCallback)
+                                         const QJSValue &errorCallback,
+                                         int timeout)
 {
     QDBusMessage message = constructMessage(m_service, m_path, m_interface, method, arguments);
     if (message.type() == QDBusMessage::InvalidMessage) {
@@ -775,11 +1041,15 @@ bool DeclarativeDBusInterface::typedCall(const QString &method, const QJSValue &
         return false;
     }
 
-    return dispatch(message, callback, errorCallback);
+    return dispatch(message, callback, errorCallback, timeout);
 }
 
 bool DeclarativeDBusInterface::dispatch(
-        const QDBusMessage &message, const QJSValue &callback, const QJSValue &errorCallback)
+        const QDBusMessage &message,
+        const QJSValue &callback,
+        const QJSValue &errorCallback,
+        int timeout,
+        QDBusPendingCallWatcher **pendingWatcher)
 {
     QDBusConnection conn = DeclarativeDBus::connection(m_bus);
 
@@ -802,14 +1072,109 @@ bool DeclarativeDBusInterface::dispatch(
         return false;
     }
 
-    QDBusPendingCall pendingCall = conn.asyncCall(message);
+    NemoDBus::ReplyCache * const cache = DeclarativeDBus::replyCache(m_bus);
+    const bool cacheable = cache->timeout(message) > 0;
+
+    QDBusMessage reply;
+    const bool cached = cacheable && cache->find(message, &reply);
+
+    if (timeout <= 0) {
+        timeout = m_timeout > 0 ? m_timeout : -1;
+    }
+
+    // A cached reply is given as a completed call, the watcher still reports it from the event
+    // loop so the callback is never invoked before call() returns and the call can be cancelled.
+    QDBusPendingCall pendingCall = cached
+            ? QDBusPendingCall::fromCompletedCall(reply)
+            : conn.asyncCall(message, timeout);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pendingCall);
     connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
             this, SLOT(pendingCallFinished(QDBusPendingCallWatcher*)));
     m_pendingCalls.insert(watcher, qMakePair(callback, errorCallback));
+    if (cacheable && !cached) {
+        m_cacheableCalls.insert(watcher, { cache, message, cache->generation() });
+    }
+    if (pendingWatcher) {
+        *pendingWatcher = watcher;
+    }
     return true;
 }
 
+void DeclarativeDBusInterface::cancelCall(QDBusPendingCallWatcher *watcher)
+{
+    // Dropping the callbacks and deleting the watcher releases everything held for the call,
+    // a reply which still arrives is discarded by QtDBus.
+    if (m_pendingCalls.remove(watcher)) {
+        m_cacheableCalls.remove(watcher);
+        delete watcher;
+        return;
+    }
+
+    // A reply which has arrived may still be queued behind others being decoded.
+    for (Delivery &delivery : m_deliveries) {
+        if (delivery.call == watcher) {
+            delivery.cancelled = true;
+        }
+    }
+}
+
+/*!
+    \qmlmethod void DBusInterface::cancelCalls()
+
+    Cancels all method calls of the interface which are waiting for a reply, or whose reply is
+    still queued behind replies decoded on worker threads. The callbacks of cancelled calls are
+    not invoked.
+
+    \since version 2.1.25
+*/
+void DeclarativeDBusInterface::cancelCalls()
+{
+    const auto watchers = m_pendingCalls.keys();
+    for (QDBusPendingCallWatcher *watcher : watchers) {
+        cancelCall(watcher);
+    }
+    for (Delivery &delivery : m_deliveries) {
+        if (delivery.call) {
+            delivery.cancelled = true;
+        }
+    }
+}
+
+/*!
+    \qmlmethod void DBusInterface::cacheReplies(string method, int timeout, list<string> invalidatingSignals)
+
+    Answers calls to \a method with the same arguments as an earlier call from a cache of replies
+    for up to \a timeout milliseconds, a \a timeout of \c 0 stops caching.  This should only be
+    used for methods with no side effects.
+
+    The replies are shared by all interfaces for the same service, object path and interface on
+    a bus, and are discarded when any of the optional \a invalidatingSignals is received.  Signals
+    of the interface are named as is, signals of other interfaces are qualified with the interface
+    name. For example \c org.freedesktop.DBus.Properties.PropertiesChanged invalidates the
+    replies when the properties of the interface change.
+
+    \since version 2.1.25
+*/
+void DeclarativeDBusInterface::cacheReplies(
+        const QString &method, int timeout, const QStringList &invalidatingSignals)
+{
+    DeclarativeDBus::replyCache(m_bus)->setTimeout(
+                m_service, m_path, m_interface, method, timeout, invalidatingSignals);
+}
+
+/*!
+    \qmlmethod void DBusInterface::invalidateCachedReplies(string method)
+
+    Discards the cached replies to \a method, or to all methods of the interface if \a method
+    is omitted.
+
+    \since version 2.1.25
+*/
+void DeclarativeDBusInterface::invalidateCachedReplies(const QString &method)
+{
+    DeclarativeDBus::replyCache(m_bus)->invalidate(m_service, m_path, m_interface, method);
+}
+
 /*!
     \qmlmethod var DBusInterface::getProperty(string name)
 
@@ -836,7 +1201,7 @@ QVariant DeclarativeDBusInterface::getProperty(const QString &name)
     if (reply.arguments().isEmpty())
         return QVariant();
 
-    return NemoDBus::demarshallDBusArgument(reply.arguments().first());
+    return demarshall(reply.arguments().first());
 }
 
 /*!
@@ -877,52 +1242,87 @@ void DeclarativeDBusInterface::componentComplete()
     m_componentCompleted = true;
     connectSignalHandler();
     connectPropertyHandler();
+    introspectMethodSignatures();
 }
 
 void DeclarativeDBusInterface::pendingCallFinished(QDBusPendingCallWatcher *watcher)
 {
     QPair<QJSValue, QJSValue> callbacks = m_pendingCalls.take(watcher);
 
-    watcher->deleteLater();
-
     QDBusPendingReply<> reply = *watcher;
 
+    const auto cacheable = m_cacheableCalls.find(watcher);
+    if (cacheable != m_cacheableCalls.end()) {
+        cacheable->cache->insert(cacheable->message, reply.reply(), cacheable->generation);
+        m_cacheableCalls.erase(cacheable);
+    }
+
     if (reply.isError()) {
-        QJSValue errorCallback = callbacks.second;
-        if (errorCallback.isCallable()) {
-            QDBusError error = reply.error();
-            QJSValueList args = { QJSValue(error.name()), QJSValue(error.message()) };
-            QJSValue result = errorCallback.call(args);
-            if (result.isError()) {
-                qmlInfo(this) << "Error executing error handling callback";
-            }
-        } else {
-            qmlInfo(this) << reply.error();
+        // Errors wait behind earlier replies which are still being decoded, like replies do.
+        const QJSValue errorCallback = callbacks.second;
+        const QDBusError error = reply.error();
+        deliver(reply.reply(), false, [this, errorCallback, error](const QVariantList &, bool) {
+            deliverError(errorCallback, error);
+        }, watcher);
+        return;
+    }
+
+    replyReceived(watcher, callbacks.first, reply.reply());
+}
+
+void DeclarativeDBusInterface::deliverError(const QJSValue &errorCallback, const QDBusError &error)
+{
+    if (errorCallback.isCallable()) {
+        QJSValueList args = { QJSValue(error.name()), QJSValue(error.message()) };
+        QJSValue result = QJSValue(errorCallback).call(args);
+        if (result.isError()) {
+            qmlInfo(this) << "Error executing error handling callback";
         }
+    } else {
+        qmlInfo(this) << error;
+    }
+}
 
+void DeclarativeDBusInterface::replyReceived(
+        QDBusPendingCallWatcher *watcher, const QJSValue &callback, const QDBusMessage &reply)
+{
+    if (!callback.isCallable()) {
+        watcher->deleteLater();
         return;
     }
 
-    QJSValue callback = callbacks.first;
-    if (!callback.isCallable())
-        return;
+    deliver(reply, !m_lazyRepliesEnabled,
+            [this, callback](const QVariantList &arguments, bool decoded) {
+        deliverReply(callback, arguments, decoded);
+    }, watcher);
+}
 
+void DeclarativeDBusInterface::deliverReply(
+        const QJSValue &callback, const QVariantList &arguments, bool decoded)
+{
     QJSEngine *engine = qjsEngine(this);
     if (!engine) {
         qmlInfo(this) << "Error getting QJSEngine";
         return;
     }
 
-    QDBusMessage message = reply.reply();
-
     QJSValueList callbackArguments;
 
-    QVariantList arguments = message.arguments();
-    foreach (QVariant argument, arguments) {
-        callbackArguments << engine->toScriptValue<QVariant>(NemoDBus::demarshallDBusArgument(argument));
+    /* Build the script values directly from the message arguments */
+    const DeclarativeDBusConverter converter(engine, demarshallOptions());
+
+    foreach (const QVariant &argument, arguments) {
+        if (decoded) {
+            callbackArguments << converter.fromVariant(argument);
+        } else if (m_lazyRepliesEnabled) {
+            callbackArguments << DeclarativeDBusLazyValue::create(
+                                     engine, argument, demarshallOptions());
+        } else {
+            callbackArguments << converter.toScriptValue(argument);
+        }
     }
 
-    QJSValue result = callback.call(callbackArguments);
+    QJSValue result = QJSValue(callback).call(callbackArguments);
     if (result.isError()) {
         qmlInfo(this) << "Error executing callback";
     }
@@ -930,14 +1330,23 @@ void DeclarativeDBusInterface::pendingCallFinished(QDBusPendingCallWatcher *watc
 
 void DeclarativeDBusInterface::signalHandler(const QDBusMessage &message)
 {
-    QVariantList arguments = message.arguments();
+    const QString name = message.member();
+
+    deliver(message, true, [this, name](const QVariantList &arguments, bool decoded) {
+        deliverSignal(name, arguments, decoded);
+    });
+}
+
+void DeclarativeDBusInterface::deliverSignal(
+        const QString &name, const QVariantList &arguments, bool decoded)
+{
     QVariantList normalized;
 
     QGenericArgument args[10];
 
     for (int i = 0; i < qMin(arguments.length(), 10); ++i) {
         const QVariant &tmp = arguments.at(i);
-        normalized.append(NemoDBus::demarshallDBusArgument(tmp));
+        normalized.append(demarshall(tmp, decoded));
     }
 
     for (int i = 0; i < normalized.count(); ++i) {
@@ -949,7 +1358,7 @@ void DeclarativeDBusInterface::signalHandler(const QDBusMessage &message)
 #endif
     }
 
-    QMetaMethod method = m_signals.value(message.member());
+    QMetaMethod method = m_signals.value(name);
     if (!method.isValid())
         return;
 
@@ -1013,6 +1422,26 @@ void DeclarativeDBusInterface::introspectionDataReceived(const QString &introspe
             if (!xml.readNextStartElement())
                 break;
 
+            if (xml.name() == QLatin1String("method")) {
+                // Remember the types of the in arguments for coercing the arguments of call().
+                const QString method = xml.attributes().value(QLatin1String("name")).toString();
+                QVector<QSharedPointer<const NemoDBus::SignaturePlan> > plans;
+                bool valid = true;
+                while (xml.readNextStartElement()) {
+                    if (xml.name() == QLatin1String("arg")
+                            && xml.attributes().value(QLatin1String("direction")) != QLatin1String("out")) {
+                        const QSharedPointer<const NemoDBus::SignaturePlan> plan
+                                = NemoDBus::SignaturePlan::fromSignature(
+                                    xml.attributes().value(QLatin1String("type")).toString());
+                        valid = valid && plan;
+                        plans.append(plan);
+                    }
+                    xml.skipCurrentElement();
+                }
+                if (valid)
+                    m_methodSignatures.insert(method, plans);
+                continue;
+            }
             if (xml.name() == QLatin1String("signal"))
                 dbusSignals.append(xml.attributes().value(QLatin1String("name")).toString());
             if (xml.name() == QLatin1String("property"))
@@ -1050,7 +1479,7 @@ void DeclarativeDBusInterface::introspectionDataReceived(const QString &introspe
         if (index < 0)
             continue;
 
-        m_properties.insert(dbusProperties.at(index), property);
+        m_properties.insert(NemoDBus::internString(dbusProperties.at(index)), property);
 
         dbusProperties.removeAt(index);
 
@@ -1067,16 +1496,19 @@ void DeclarativeDBusInterface::notifyPropertyChange(const QDBusMessage &message)
     const QVariantList arguments = message.arguments();
 
     if (arguments.value(0) == m_interface) {
-        updatePropertyValues(arguments.value(1).value<QDBusArgument>());
-
-        foreach (const QString &name, arguments.value(2).value<QStringList>()) {
-            if (m_properties.contains(name)) {
-                queryPropertyValues();
-                break;
+        const bool threadable = propertiesThreadable();
+        deliver(message, threadable, [this](const QVariantList &arguments, bool decoded) {
+            updatePropertyValues(arguments.value(1), decoded);
+
+            foreach (const QString &name, arguments.value(2).value<QStringList>()) {
+                if (m_properties.contains(name)) {
+                    queryPropertyValues();
+                    break;
+                }
             }
-        }
 
-        emit propertiesChanged();
+            emit propertiesChanged();
+        });
     }
 }
 
@@ -1186,7 +1618,9 @@ void DeclarativeDBusInterface::queryPropertyValues()
 
 void DeclarativeDBusInterface::propertyValuesReceived(const QDBusMessage &message)
 {
-    updatePropertyValues(message.arguments().value(0).value<QDBusArgument>());
+    deliver(message, propertiesThreadable(), [this](const QVariantList &arguments, bool decoded) {
+        updatePropertyValues(arguments.value(0), decoded);
+    });
 }
 
 void DeclarativeDBusInterface::serviceRegistered()
@@ -1196,6 +1630,7 @@ void DeclarativeDBusInterface::serviceRegistered()
 
     connectSignalHandler();
     connectPropertyHandler();
+    introspectMethodSignatures();
 }
 
 void DeclarativeDBusInterface::serviceUnregistered()
@@ -1204,17 +1639,32 @@ void DeclarativeDBusInterface::serviceUnregistered()
     emit statusChanged();
 }
 
-void DeclarativeDBusInterface::updatePropertyValues(const QDBusArgument &argument)
+void DeclarativeDBusInterface::updatePropertyValues(const QVariant &values, bool decoded)
 {
-    if (m_propertiesEnabled) {
+    if (m_propertiesEnabled && decoded) {
+        const QVariantMap map = values.toMap();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            QMetaProperty property = m_properties.value(it.key());
+            if (property.isValid()) {
+                property.write(this, property.userType() == QMetaType::QVariant
+                               ? demarshall(it.value(), true)
+                               : it.value());
+            }
+        }
+    } else if (m_propertiesEnabled) {
+        const QDBusArgument argument = values.value<QDBusArgument>();
         argument.beginMap();
         while (!argument.atEnd()) {
             argument.beginMapEntry();
 
-            const QString name = argument.asVariant().toString();
+            // Interned like the keys of m_properties, so the lookup can compare by pointer.
+            const QString name = NemoDBus::internString(argument.asVariant().toString());
             QMetaProperty property = m_properties.value(name);
             if (property.isValid()) {
-                property.write(this, NemoDBus::demarshallDBusArgument(argument.asVariant()));
+                // Only var properties can hold a script value.
+                property.write(this, property.userType() == QMetaType::QVariant
+                               ? demarshall(argument.asVariant())
+                               : NemoDBus::demarshallDBusArgument(argument.asVariant()));
             }
 
             argument.endMapEntry();
@@ -1232,6 +1682,20 @@ void DeclarativeDBusInterface::invalidateIntrospection()
     m_providesPropertyInterface = false;
     m_signals.clear();
     m_properties.clear();
+    m_methodSignatures.clear();
+}
+
+void DeclarativeDBusInterface::introspectMethodSignatures()
+{
+    if (m_componentCompleted
+            && m_methodSignaturesEnabled
+            && !m_introspected
+            && !m_service.isEmpty()
+            && !m_path.isEmpty()
+            && !m_interface.isEmpty()
+            && serviceAvailable()) {
+        introspect();
+    }
 }
 
 void DeclarativeDBusInterface::introspect()
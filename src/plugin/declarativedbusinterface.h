@@ -27,8 +27,11 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
+#include <QVector>
 #include <QPair>
 #include <QPointer>
+#include <QSharedPointer>
 #include <QVariant>
 #include <QDBusArgument>
 #include <QJSValue>
@@ -38,8 +41,16 @@
 #include <QDBusMessage>
 #include <QDBusServiceWatcher>
 #include <QPair>
+#include <QFutureWatcher>
+
+#include <functional>
 
 #include "declarativedbus.h"
+#include "dbus.h"
+
+namespace NemoDBus {
+class SignaturePlan;
+}
 
 class DeclarativeDBusInterface : public QObject, public QQmlParserStatus
 {
@@ -52,6 +63,11 @@ class DeclarativeDBusInterface : public QObject, public QQmlParserStatus
     Q_PROPERTY(DeclarativeDBus::BusType bus READ bus WRITE setBus NOTIFY busChanged)
     Q_PROPERTY(bool signalsEnabled READ signalsEnabled WRITE setSignalsEnabled NOTIFY signalsEnabledChanged)
     Q_PROPERTY(bool propertiesEnabled READ propertiesEnabled WRITE setPropertiesEnabled NOTIFY propertiesEnabledChanged)
+    Q_PROPERTY(bool arrayBuffersEnabled READ arrayBuffersEnabled WRITE setArrayBuffersEnabled NOTIFY arrayBuffersEnabledChanged)
+    Q_PROPERTY(bool lazyRepliesEnabled READ lazyRepliesEnabled WRITE setLazyRepliesEnabled NOTIFY lazyRepliesEnabledChanged)
+    Q_PROPERTY(int threadedDecodingThreshold READ threadedDecodingThreshold WRITE setThreadedDecodingThreshold NOTIFY threadedDecodingThresholdChanged)
+    Q_PROPERTY(bool methodSignaturesEnabled READ methodSignaturesEnabled WRITE setMethodSignaturesEnabled NOTIFY methodSignaturesEnabledChanged)
+    Q_PROPERTY(int timeout READ timeout WRITE setTimeout NOTIFY timeoutChanged)
 
     Q_INTERFACES(QQmlParserStatus)
 
@@ -89,13 +105,36 @@ public:
 
     void propertiesConnected() const;
 
-    Q_INVOKABLE void call(const QString &method,
-                          const QJSValue &arguments = QJSValue::UndefinedValue,
-                          const QJSValue &callback = QJSValue::UndefinedValue,
-                          const QJSValue &errorCallback = QJSValue::UndefinedValue);
+    bool arrayBuffersEnabled() const;
+    void setArrayBuffersEnabled(bool enabled);
+
+    bool lazyRepliesEnabled() const;
+    void setLazyRepliesEnabled(bool enabled);
+
+    int threadedDecodingThreshold() const;
+    void setThreadedDecodingThreshold(int threshold);
+
+    bool methodSignaturesEnabled() const;
+    void setMethodSignaturesEnabled(bool enabled);
+
+    int timeout() const;
+    void setTimeout(int timeout);
+
+    Q_INVOKABLE QJSValue call(const QString &method,
+                              const QJSValue &arguments = QJSValue::UndefinedValue,
+                              const QJSValue &callback = QJSValue::UndefinedValue,
+                              const QJSValue &errorCallback = QJSValue::UndefinedValue,
+                              int timeout = 0);
     Q_INVOKABLE bool typedCall(const QString &method, const QJSValue &arguments,
                                const QJSValue &callback = QJSValue::UndefinedValue,
-                               const QJSValue &errorCallback = QJSValue::UndefinedValue);
+                               const QJSValue &errorCallback = QJSValue::UndefinedValue,
+                               int timeout = 0);
+
+    Q_INVOKABLE void cancelCalls();
+
+    Q_INVOKABLE void cacheReplies(const QString &method, int timeout,
+                                  const QStringList &invalidatingSignals = QStringList());
+    Q_INVOKABLE void invalidateCachedReplies(const QString &method = QString());
 
     Q_INVOKABLE QVariant getProperty(const QString &name);
     Q_INVOKABLE void setProperty(const QString &name, const QVariant &newValue);
@@ -114,6 +153,11 @@ signals:
     void busChanged();
     void signalsEnabledChanged();
     void propertiesEnabledChanged();
+    void arrayBuffersEnabledChanged();
+    void lazyRepliesEnabledChanged();
+    void threadedDecodingThresholdChanged();
+    void methodSignaturesEnabledChanged();
+    void timeoutChanged();
     void propertiesChanged();
 
 private slots:
@@ -126,19 +170,63 @@ private slots:
     void serviceRegistered();
     void serviceUnregistered();
 
+    void decodingFinished();
+
 private:
+    friend class DeclarativeDBusPendingCall;
+
+    // Receives the message arguments, decoded if decoded is true.
+    typedef std::function<void (const QVariantList &arguments, bool decoded)> DeliveryHandler;
+
+    struct CacheableCall
+    {
+        NemoDBus::ReplyCache *cache;
+        QDBusMessage message;
+        quint64 generation;
+    };
+
+    struct Delivery
+    {
+        QDBusPendingCallWatcher *call;
+        bool cancelled;
+        QFutureWatcher<QVariantList> *watcher;
+        QVariantList arguments;
+        DeliveryHandler handler;
+    };
+
     void invalidateIntrospection();
     void introspect();
+    void introspectMethodSignatures();
     bool dispatch(
-            const QDBusMessage &message, const QJSValue &callback, const QJSValue &errorCallback);
+            const QDBusMessage &message,
+            const QJSValue &callback,
+            const QJSValue &errorCallback,
+            int timeout,
+            QDBusPendingCallWatcher **pendingWatcher = nullptr);
+    void cancelCall(QDBusPendingCallWatcher *watcher);
     void disconnectSignalHandler();
     void connectSignalHandler();
     void disconnectPropertyHandler();
     void connectPropertyHandler();
     void queryPropertyValues();
-    void updatePropertyValues(const QDBusArgument &values);
+    void updatePropertyValues(const QVariant &values, bool decoded);
+    NemoDBus::DemarshallOptions demarshallOptions() const;
+    bool propertiesThreadable() const;
+    QVariant demarshall(const QVariant &argument, bool decoded = false) const;
+
+    void deliver(
+            const QDBusMessage &message,
+            bool threadable,
+            const DeliveryHandler &handler,
+            QDBusPendingCallWatcher *call = nullptr);
+    void replyReceived(
+            QDBusPendingCallWatcher *watcher, const QJSValue &callback, const QDBusMessage &reply);
+    void deliverReply(const QJSValue &callback, const QVariantList &arguments, bool decoded);
+    void deliverError(const QJSValue &errorCallback, const QDBusError &error);
+    void deliverSignal(const QString &name, const QVariantList &arguments, bool decoded);
 
     bool marshallDBusArgument(QDBusMessage &msg, const QJSValue &arg);
+    bool coerceArguments(QDBusMessage &message, const QJSValue &arguments);
     QDBusMessage constructMessage(const QString &service,
                                   const QString &path,
                                   const QString &interface,
@@ -156,8 +244,10 @@ private:
     DeclarativeDBus::BusType m_bus;
     QMap<QDBusPendingCallWatcher *, QPair<QJSValue, QJSValue> >
     m_pendingCalls; // pair: success and error callback
+    QHash<QDBusPendingCallWatcher *, CacheableCall> m_cacheableCalls;
     QMap<QString, QMetaMethod> m_signals;
     QMap<QString, QMetaProperty> m_properties;
+    QHash<QString, QVector<QSharedPointer<const NemoDBus::SignaturePlan> > > m_methodSignatures;
     bool m_componentCompleted;
     bool m_signalsEnabled;
     bool m_signalsConnected;
@@ -165,6 +255,12 @@ private:
     bool m_propertiesConnected;
     bool m_introspected;
     bool m_providesPropertyInterface;
+    bool m_arrayBuffersEnabled;
+    bool m_lazyRepliesEnabled;
+    int m_threadedDecodingThreshold;
+    bool m_methodSignaturesEnabled;
+    int m_timeout;
+    QList<Delivery> m_deliveries;
 
     QDBusServiceWatcher *m_serviceWatcher;
 };
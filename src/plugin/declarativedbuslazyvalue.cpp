@@ -0,0 +1,233 @@
+/****************************************************************************************
+**
+** Copyright (C) 2026 Jolla Ltd.
+** All rights reserved.
+**
+** You may use this file under the terms of the GNU Lesser General
+** Public License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+** Lesser General Public License for more details.
+**
+****************************************************************************************/
+
+#include "declarativedbuslazyvalue.h"
+#include "declarativedbusconverter.h"
+
+#include "private/signatureplan.h"
+
+#include <QDBusVariant>
+#include <QJSEngine>
+
+using NemoDBus::SignaturePlan;
+
+/*!
+    \qmltype DBusLazyValue
+    \inqmlmodule Nemo.DBus
+    \brief Gives access to a D-Bus array, dictionary or structure decoded on demand
+
+    A DBusLazyValue is passed to method call callbacks in place of a container value when
+    \l {DBusInterface::lazyRepliesEnabled}{lazyRepliesEnabled} is set. The elements of the
+    container are only decoded when they are accessed, elements which are containers
+    themselves are again given as DBusLazyValue objects.
+
+    This type cannot be created from QML.
+
+    \since version 2.1.25
+*/
+
+DeclarativeDBusLazyValue::DeclarativeDBusLazyValue(
+        QJSEngine *engine,
+        const QDBusArgument &argument,
+        const QSharedPointer<const SignaturePlan> &plan,
+        NemoDBus::DemarshallOptions options)
+    : m_engine(engine)
+    , m_argument(argument)
+    , m_plan(plan)
+    , m_options(options)
+    , m_expanded(false)
+{
+}
+
+DeclarativeDBusLazyValue::~DeclarativeDBusLazyValue()
+{
+}
+
+QJSValue DeclarativeDBusLazyValue::create(
+        QJSEngine *engine, const QVariant &argument, NemoDBus::DemarshallOptions options)
+{
+    QVariant value = argument;
+    if (value.userType() == qMetaTypeId<QDBusVariant>()) {
+        value = value.value<QDBusVariant>().variant();
+    }
+
+    if (value.userType() == qMetaTypeId<QDBusArgument>()) {
+        const QDBusArgument dbusArgument = value.value<QDBusArgument>();
+        const QSharedPointer<const SignaturePlan> plan = SignaturePlan::fromArgument(dbusArgument);
+        if (plan) {
+            switch (plan->node(0).kind) {
+            case SignaturePlan::Array:
+            case SignaturePlan::Map:
+            case SignaturePlan::Structure:
+                return engine->newQObject(
+                            new DeclarativeDBusLazyValue(engine, dbusArgument, plan, options));
+            default:
+                /* Basic values and byte, string and numeric arrays are cheap to decode */
+                break;
+            }
+        }
+    }
+
+    return DeclarativeDBusConverter(engine, options).toScriptValue(value);
+}
+
+/*!
+    \qmlproperty string DBusLazyValue::signature
+
+    This property holds the D-Bus signature of the value.
+*/
+QString DeclarativeDBusLazyValue::signature() const
+{
+    return QString::fromLatin1(m_plan->signature());
+}
+
+/*!
+    \qmlproperty int DBusLazyValue::count
+
+    This property holds the number of elements in an array, entries in a dictionary or fields
+    in a structure.
+*/
+int DeclarativeDBusLazyValue::count()
+{
+    expand();
+
+    return m_elements.count();
+}
+
+/*!
+    \qmlmethod var DBusLazyValue::at(int index)
+
+    Returns the element at \a index. For a dictionary this is the value of the entry at
+    \a index in the order they were received.
+*/
+QJSValue DeclarativeDBusLazyValue::at(int index)
+{
+    expand();
+
+    if (index < 0 || index >= m_elements.count()) {
+        return QJSValue();
+    }
+
+    QJSValue &value = m_values[index];
+    if (value.isUndefined()) {
+        value = create(m_engine, m_elements.at(index), m_options);
+    }
+    return value;
+}
+
+/*!
+    \qmlmethod var DBusLazyValue::value(string key)
+
+    Returns the value of the dictionary entry with the given \a key, or \c undefined if
+    there is no such entry.
+*/
+QJSValue DeclarativeDBusLazyValue::value(const QString &key)
+{
+    expand();
+
+    return at(m_keyIndexes.value(key, -1));
+}
+
+/*!
+    \qmlmethod list<string> DBusLazyValue::keys()
+
+    Returns the keys of a dictionary in the order they were received.
+*/
+QStringList DeclarativeDBusLazyValue::keys()
+{
+    expand();
+
+    return m_keys;
+}
+
+/*!
+    \qmlmethod var DBusLazyValue::toValue()
+
+    Decodes the whole value and returns it as it would have been passed to the callback
+    without \l {DBusInterface::lazyRepliesEnabled}{lazyRepliesEnabled}.
+*/
+QJSValue DeclarativeDBusLazyValue::toValue()
+{
+    expand();
+
+    const bool map = m_plan->node(0).kind == SignaturePlan::Map;
+    QJSValue result = map ? m_engine->newObject() : m_engine->newArray(m_elements.count());
+
+    for (int i = 0; i < m_elements.count(); ++i) {
+        /* Elements which were accessed have already been read from the message */
+        QJSValue value = at(i);
+        if (DeclarativeDBusLazyValue *lazyValue = qobject_cast<DeclarativeDBusLazyValue *>(
+                    value.toQObject())) {
+            value = lazyValue->toValue();
+        }
+
+        if (map) {
+            result.setProperty(m_keys.at(i), value);
+        } else {
+            result.setProperty(i, value);
+        }
+    }
+
+    return result;
+}
+
+void DeclarativeDBusLazyValue::expand()
+{
+    if (m_expanded) {
+        return;
+    }
+    m_expanded = true;
+
+    /* Only this level is read, nested containers are returned as
+     * arguments of their own and left for when they are accessed */
+    switch (m_plan->node(0).kind) {
+    case SignaturePlan::Map:
+        m_argument.beginMap();
+        while (!m_argument.atEnd()) {
+            m_argument.beginMapEntry();
+            const QString key = NemoDBus::demarshallDBusArgument(m_argument.asVariant()).toString();
+            m_keyIndexes.insert(key, m_elements.count());
+            m_keys.append(key);
+            m_elements.append(m_argument.asVariant());
+            m_argument.endMapEntry();
+        }
+        m_argument.endMap();
+        break;
+    case SignaturePlan::Structure:
+        m_argument.beginStructure();
+        while (!m_argument.atEnd()) {
+            m_elements.append(m_argument.asVariant());
+        }
+        m_argument.endStructure();
+        break;
+    default:
+        m_argument.beginArray();
+        while (!m_argument.atEnd()) {
+            m_elements.append(m_argument.asVariant());
+        }
+        m_argument.endArray();
+        break;
+    }
+
+    m_values.resize(m_elements.count());
+}
@@ -0,0 +1,86 @@
+/****************************************************************************************
+**
+** Copyright (C) 2026 Jolla Ltd.
+** All rights reserved.
+**
+** You may use this file under the terms of the GNU Lesser General
+** Public License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+** Lesser General Public License for more details.
+**
+****************************************************************************************/
+
+#ifndef DECLARATIVEDBUSLAZYVALUE_H
+#define DECLARATIVEDBUSLAZYVALUE_H
+
+#include <QObject>
+#include <QDBusArgument>
+#include <QHash>
+#include <QJSValue>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include "dbus.h"
+
+QT_BEGIN_NAMESPACE
+class QJSEngine;
+QT_END_NAMESPACE
+
+namespace NemoDBus {
+class SignaturePlan;
+}
+
+class DeclarativeDBusLazyValue : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString signature READ signature CONSTANT)
+    Q_PROPERTY(int count READ count CONSTANT)
+
+public:
+    ~DeclarativeDBusLazyValue();
+
+    static QJSValue create(
+            QJSEngine *engine, const QVariant &argument, NemoDBus::DemarshallOptions options);
+
+    QString signature() const;
+    int count();
+
+    Q_INVOKABLE QJSValue at(int index);
+    Q_INVOKABLE QJSValue value(const QString &key);
+    Q_INVOKABLE QStringList keys();
+    Q_INVOKABLE QJSValue toValue();
+
+private:
+    DeclarativeDBusLazyValue(
+            QJSEngine *engine,
+            const QDBusArgument &argument,
+            const QSharedPointer<const NemoDBus::SignaturePlan> &plan,
+            NemoDBus::DemarshallOptions options);
+
+    void expand();
+
+    QJSEngine * const m_engine;
+    const QDBusArgument m_argument;
+    const QSharedPointer<const NemoDBus::SignaturePlan> m_plan;
+    const NemoDBus::DemarshallOptions m_options;
+    QVariantList m_elements;
+    QVector<QJSValue> m_values;
+    QStringList m_keys;
+    QHash<QString, int> m_keyIndexes;
+    bool m_expanded;
+};
+
+#endif
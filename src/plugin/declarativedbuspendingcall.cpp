@@ -0,0 +1,66 @@
+/****************************************************************************************
+**
+** Copyright (C) 2026 Jolla Ltd.
+** All rights reserved.
+**
+** You may use this file under the terms of the GNU Lesser General
+** Public License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+** Lesser General Public License for more details.
+**
+****************************************************************************************/
+
+#include "declarativedbuspendingcall.h"
+#include "declarativedbusinterface.h"
+
+#include <QDBusPendingCallWatcher>
+
+/*!
+    \qmltype DBusPendingCall
+    \inqmlmodule Nemo.DBus
+    \brief Refers to a method call waiting for its reply
+
+    A DBusPendingCall is returned by \l {DBusInterface::call()}{DBusInterface.call()} when a
+    callback is given. Cancelling the call releases the callbacks and ignores the reply, which
+    is useful when a newer call makes the result of an earlier one irrelevant.
+
+    This type cannot be created from QML.
+
+    \since version 2.1.25
+*/
+
+DeclarativeDBusPendingCall::DeclarativeDBusPendingCall(
+        DeclarativeDBusInterface *interface, QDBusPendingCallWatcher *watcher)
+    : m_interface(interface)
+    , m_watcher(watcher)
+{
+}
+
+DeclarativeDBusPendingCall::~DeclarativeDBusPendingCall()
+{
+}
+
+/*!
+    \qmlmethod void DBusPendingCall::cancel()
+
+    Cancels the call if it is still waiting for a reply, or if its reply is still queued behind
+    replies decoded on worker threads. Neither the callback nor the error callback of a
+    cancelled call is invoked.
+*/
+void DeclarativeDBusPendingCall::cancel()
+{
+    if (m_interface && m_watcher) {
+        m_interface->cancelCall(m_watcher);
+    }
+}
@@ -0,0 +1,51 @@
+/****************************************************************************************
+**
+** Copyright (C) 2026 Jolla Ltd.
+** All rights reserved.
+**
+** You may use this file under the terms of the GNU Lesser General
+** Public License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file license.lgpl included in the packaging
+** of this file.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+** Lesser General Public License for more details.
+**
+****************************************************************************************/
+
+#ifndef DECLARATIVEDBUSPENDINGCALL_H
+#define DECLARATIVEDBUSPENDINGCALL_H
+
+#include <QObject>
+#include <QPointer>
+
+QT_BEGIN_NAMESPACE
+class QDBusPendingCallWatcher;
+QT_END_NAMESPACE
+
+class DeclarativeDBusInterface;
+
+class DeclarativeDBusPendingCall : public QObject
+{
+    Q_OBJECT
+
+public:
+    DeclarativeDBusPendingCall(DeclarativeDBusInterface *interface, QDBusPendingCallWatcher *watcher);
+    ~DeclarativeDBusPendingCall();
+
+    Q_INVOKABLE void cancel();
+
+private:
+    QPointer<DeclarativeDBusInterface> m_interface;
+    QPointer<QDBusPendingCallWatcher> m_watcher;
+};
+
+#endif
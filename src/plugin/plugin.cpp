@@ -30,6 +30,8 @@
 #include "declarativedbus.h"
 #include "declarativedbusadaptor.h"
 #include "declarativedbusinterface.h"
+#include "declarativedbuslazyvalue.h"
+#include "declarativedbuspendingcall.h"
 
 #include "dbus.h"
 
@@ -51,6 +53,10 @@ public:
         qmlRegisterUncreatableType<DeclarativeDBus>(uri, 2, 0, "DBus", "Cannot create DBus objects");
         qmlRegisterType<DeclarativeDBusAdaptor>(uri, 2, 0, "DBusAdaptor");
         qmlRegisterType<DeclarativeDBusInterface>(uri, 2, 0, "DBusInterface");
+        qmlRegisterUncreatableType<DeclarativeDBusLazyValue>(
+                    uri, 2, 0, "DBusLazyValue", "Cannot create DBusLazyValue objects");
+        qmlRegisterUncreatableType<DeclarativeDBusPendingCall>(
+                    uri, 2, 0, "DBusPendingCall", "Cannot create DBusPendingCall objects");
     }
 };
 
@@ -26,9 +26,15 @@ SOURCES += \
     plugin.cpp \
     declarativedbus.cpp \
     declarativedbusadaptor.cpp \
+    declarativedbusconverter.cpp \
     declarativedbusinterface.cpp \
+    declarativedbuslazyvalue.cpp \
+    declarativedbuspendingcall.cpp \
 
 HEADERS += \
     declarativedbus.h \
     declarativedbusadaptor.h \
+    declarativedbusconverter.h \
     declarativedbusinterface.h \
+    declarativedbuslazyvalue.h \
+    declarativedbuspendingcall.h \
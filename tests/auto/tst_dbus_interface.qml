@@ -235,6 +235,23 @@ TestCase {
         echo, {type:'s',value:'COMPLEX4'},        "echo: complex4",              [255,true,32767,2147483647,9223372036854775807,65535,4294967295,18446744073709551615,3.75,"string","/obj/path","sointu"],
         repr, {type:'a{sv}',value:{a:1, b:"two"}},"repr: array string-variant",  'array [ key string:"a" val variant int32:1 key string:"b" val variant string:"two" ]',
         echo, {type:'a{sv}',value:{a:1, b:"two"}},"echo: array string-variant",  {a:1, b:"two"},
+        repr, {type:'(si)',value:["a",1]},        "repr: struct",                'struct { string:"a" int32:1 }',
+        echo, {type:'(si)',value:["a",1]},        "echo: struct",                ["a",1],
+        repr, {type:'a(ii)',value:[[1,2],[3,4]]}, "repr: array struct",          'array [ struct { int32:1 int32:2 } struct { int32:3 int32:4 } ]',
+        echo, {type:'a(ii)',value:[[1,2],[3,4]]}, "echo: array struct",          [[1,2],[3,4]],
+        repr, {type:'a(ii)',value:[]},            "repr: empty array struct",    'array [ ]',
+        repr, {type:'a{sa{sv}}',value:{a:{b:1}}}, "repr: nested dict",           'array [ key string:"a" val array [ key string:"b" val variant int32:1 ] ]',
+        echo, {type:'a{sa{sv}}',value:{a:{b:1}}}, "echo: nested dict",           {a:{b:1}},
+        repr, {type:'v',value:{type:'a(su)',value:[["a",1]]}}, "repr: variant typed container", 'variant array [ struct { string:"a" uint32:1 } ]',
+        repr, {type:'a{sv}',value:{a:{type:'s',value:"x"}}},   "repr: dict with type and value", 'array [ key string:"a" val variant array [ key string:"type" val variant string:"s" key string:"value" val variant string:"x" ] ]',
+        repr, {type:'ay',value:new Uint8Array([1,2,255])},      "repr: byte array from Uint8Array",   'array [ byte:1 byte:2 byte:255 ]',
+        repr, {type:'ay',value:new Uint8Array([1,2,3,4]).subarray(1,3)}, "repr: byte array from view", 'array [ byte:2 byte:3 ]',
+        repr, {type:'ai',value:new Int32Array([1,-2,3])},       "repr: int32 array from Int32Array",  'array [ int32:1 int32:-2 int32:3 ]',
+        repr, {type:'ai',value:new Int16Array([1,-2])},         "repr: int32 array from Int16Array",  'array [ int32:1 int32:-2 ]',
+        repr, {type:'ad',value:new Float64Array([1.25,1.5])},   "repr: double array from Float64Array", 'array [ double:1.25 double:1.5 ]',
+        repr, {type:'v',value:new Int32Array([4,5])},           "repr: variant from Int32Array",      'variant array [ int32:4 int32:5 ]',
+        repr, {type:'ai',value:new ArrayBuffer(8)},             "repr: int32 array from ArrayBuffer", 'ERR',
+        repr, {type:'ad',value:new DataView(new ArrayBuffer(8))}, "repr: double array from DataView", 'ERR',
     ]
 
     function methodEnd(res) {
@@ -281,6 +298,324 @@ TestCase {
         tryCompare(testsrv, "string", "goodbye")
     }
 
+    function test_arrayBuffer() {
+        buffersrv.typedCall("echo", {type:'ay', value:[1,2,255]}, function(result) {
+            buffersrv.bytes = result instanceof ArrayBuffer ? new Uint8Array(result) : []
+        })
+
+        tryCompare(buffersrv, "byteCount", 3)
+        compare(buffersrv.bytes[0], 1)
+        compare(buffersrv.bytes[2], 255)
+    }
+
+    function test_typedArrays() {
+        buffersrv.values = []
+        buffersrv.typedCall("echo", [{type:'ai', value:[1,-2,3]}, {type:'ad', value:[0.5,1.5]}],
+                            function(integers, doubles) {
+            buffersrv.values = [integers instanceof Int32Array, integers[1],
+                                doubles instanceof Float64Array, doubles[1]]
+        })
+
+        tryCompare(buffersrv, "valueCount", 4)
+        compare(buffersrv.values, [true, -2, true, 1.5])
+    }
+
+    function test_lazyReply() {
+        lazysrv.values = []
+        lazysrv.typedCall("echo", {type:'s', value:'COMPLEX2'}, function(result) {
+            lazysrv.values = [result.signature, result.count, result.value("bar"),
+                              JSON.stringify(result.toValue())]
+        })
+
+        tryCompare(lazysrv, "valueCount", 4)
+        compare(lazysrv.values[0], "a{si}")
+        compare(lazysrv.values[1], 3)
+        compare(lazysrv.values[2], 2)
+        compare(JSON.parse(lazysrv.values[3]), {foo:1,bar:2,baf:3})
+    }
+
+    function test_threadedDecoding() {
+        threadsrv.values = []
+        threadsrv.typedCall("echo", {type:'s', value:'COMPLEX2'}, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        })
+        threadsrv.typedCall("echo", {type:'i', value:5}, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        })
+
+        tryCompare(threadsrv, "valueCount", 2)
+        compare(threadsrv.values[0], {foo:1,bar:2,baf:3})
+        compare(threadsrv.values[1], 5)
+    }
+
+    function test_threadedDecodingError() {
+        // An error reply waits for the reply before it which is decoded on a worker thread.
+        threadsrv.values = []
+        threadsrv.typedCall("echo", {type:'s', value:'COMPLEX2'}, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        })
+        threadsrv.call("noSuchMethod", undefined, function() {
+            threadsrv.values = threadsrv.values.concat(["reply"])
+        }, function(name, message) {
+            threadsrv.values = threadsrv.values.concat([name])
+        })
+
+        tryCompare(threadsrv, "valueCount", 2)
+        compare(threadsrv.values[0], {foo:1,bar:2,baf:3})
+        compare(threadsrv.values[1], "org.freedesktop.DBus.Error.UnknownMethod")
+    }
+
+    function test_threadedPropertyDecoding() {
+        // Typed properties get the same values whether they were decoded on a worker thread or,
+        // with array buffers enabled, on the GUI thread.
+        testsrv.setProperty("Integer", 99)
+        tryCompare(threadpropertysrv, "integer", 99)
+        tryCompare(bufferpropertysrv, "integer", 99)
+
+        testsrv.setProperty("String", "threaded")
+        tryCompare(threadpropertysrv, "string", "threaded")
+        tryCompare(bufferpropertysrv, "string", "threaded")
+    }
+
+    function test_timeout() {
+        compare(testsrv.timeout, 0)
+
+        threadsrv.values = []
+        threadsrv.typedCall("echo", {type:'i', value:7}, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        }, undefined, 5000)
+        threadsrv.call("echo", 8, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        }, undefined, 5000)
+
+        tryCompare(threadsrv, "valueCount", 2)
+        compare(threadsrv.values, [7, 8])
+
+        // The service replies after two seconds, long after the timeout has passed.
+        threadsrv.values = []
+        threadsrv.call("delay", 2000, function() {
+            threadsrv.values = threadsrv.values.concat(["reply"])
+        }, function(name, message) {
+            threadsrv.values = threadsrv.values.concat([name])
+        }, 100)
+
+        tryCompare(threadsrv, "valueCount", 1)
+        compare(threadsrv.values, ["org.freedesktop.DBus.Error.NoReply"])
+    }
+
+    function test_cancel() {
+        threadsrv.values = []
+        var pendingCall = threadsrv.call("echo", 1, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        })
+        verify(pendingCall !== null)
+        pendingCall.cancel()
+
+        threadsrv.call("echo", 2, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        })
+
+        // Replies arrive in order, so the cancelled call has been answered by now.
+        tryCompare(threadsrv, "valueCount", 1)
+        compare(threadsrv.values, [2])
+
+        compare(threadsrv.call("echo", 3), null)
+
+        // A reply queued behind one being decoded on a worker thread is not delivered either.
+        threadsrv.values = []
+        var queuedCall = null
+        threadsrv.typedCall("echo", {type:'s', value:'COMPLEX2'}, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+            queuedCall.cancel()
+        })
+        queuedCall = threadsrv.call("echo", 4, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        })
+        threadsrv.call("echo", 5, function(result) {
+            threadsrv.values = threadsrv.values.concat([result])
+        })
+
+        tryCompare(threadsrv, "valueCount", 2)
+        compare(threadsrv.values[0], {foo:1,bar:2,baf:3})
+        compare(threadsrv.values[1], 5)
+    }
+
+    function test_replyCache() {
+        function getInteger() {
+            cachesrv.call("Get", ["org.nemomobile.dbustestd", "Integer"], function(value) {
+                cachesrv.values = cachesrv.values.concat([value])
+            })
+        }
+
+        testsrv.setProperty("Integer", 27)
+        tryCompare(testsrv, "integer", 27)
+
+        cachesrv.cacheReplies("Get", 60000)
+        getInteger()
+        tryCompare(cachesrv, "valueCount", 1)
+
+        testsrv.setProperty("Integer", 28)
+        tryCompare(testsrv, "integer", 28)
+
+        getInteger()
+        tryCompare(cachesrv, "valueCount", 2)
+
+        cachesrv.invalidateCachedReplies("Get")
+        getInteger()
+        tryCompare(cachesrv, "valueCount", 3)
+
+        cachesrv.cacheReplies("Get", 0)
+
+        compare(cachesrv.values, [27, 27, 28])
+    }
+
+    function test_replyCacheInvalidation() {
+        function getInteger(next) {
+            cachesrv.call("Get", ["org.nemomobile.dbustestd", "Integer"], function(value) {
+                cachesrv.values = cachesrv.values.concat([value])
+                if (next) {
+                    next()
+                }
+            })
+        }
+        // The service emits any signal before it replies, so the cache has seen the signal by
+        // the time the callback is invoked.
+        function setInteger(value, next) {
+            cachesrv.typedCall("Set", [{type:'s', value:"org.nemomobile.dbustestd"},
+                                       {type:'s', value:"Integer"},
+                                       {type:'v', value:value}], next)
+        }
+        function ping(next) {
+            testsrv.typedCall("ping", {type:'i', value:1}, next)
+        }
+
+        cachesrv.values = []
+        cachesrv.cacheReplies("Get", 60000, ["PropertiesChanged"])
+        setInteger(31, function() {
+            getInteger(function() {
+                setInteger(32, function() {
+                    getInteger()
+                })
+            })
+        })
+
+        tryCompare(cachesrv, "valueCount", 2)
+        compare(cachesrv.values, [31, 32])
+
+        cachesrv.values = []
+        cachesrv.cacheReplies("Get", 60000, ["org.nemomobile.dbustestd.pong"])
+        getInteger(function() {
+            setInteger(33, function() {
+                getInteger(function() {
+                    ping(function() {
+                        getInteger()
+                    })
+                })
+            })
+        })
+
+        tryCompare(cachesrv, "valueCount", 3)
+        compare(cachesrv.values, [32, 32, 33])
+
+        cachesrv.cacheReplies("Get", 0)
+    }
+
+    function test_methodSignatures() {
+        // The value is only marshalled as a variant once the interface has been introspected,
+        // until then the service rejects the call and it is made again.
+        var attempts = 0
+        function setInteger() {
+            ++attempts
+            propertysrv.call("Set", ['org.nemomobile.dbustestd', 'Integer', 451], undefined,
+                             function(error) {
+                if (attempts < 50) {
+                    setInteger()
+                }
+            })
+        }
+
+        setInteger()
+        tryCompare(testsrv, "integer", 451)
+    }
+
+    DBusInterface {
+        id:              cachesrv
+        service:         'org.nemomobile.dbustestd'
+        path:            '/'
+        iface:           'org.freedesktop.DBus.Properties'
+
+        property var values: []
+        property int valueCount: values.length
+    }
+
+    DBusInterface {
+        id:              propertysrv
+        service:         'org.nemomobile.dbustestd'
+        path:            '/'
+        iface:           'org.freedesktop.DBus.Properties'
+        methodSignaturesEnabled: true
+    }
+
+    DBusInterface {
+        id:              threadsrv
+        service:         'org.nemomobile.dbustestd'
+        path:            '/'
+        iface:           'org.nemomobile.dbustestd'
+        threadedDecodingThreshold: 2
+
+        property var values: []
+        property int valueCount: values.length
+    }
+
+    DBusInterface {
+        id:              threadpropertysrv
+        service:         'org.nemomobile.dbustestd'
+        path:            '/'
+        iface:           'org.nemomobile.dbustestd'
+        propertiesEnabled: true
+        threadedDecodingThreshold: 1
+
+        property int integer
+        property string string
+    }
+
+    DBusInterface {
+        id:              bufferpropertysrv
+        service:         'org.nemomobile.dbustestd'
+        path:            '/'
+        iface:           'org.nemomobile.dbustestd'
+        propertiesEnabled: true
+        arrayBuffersEnabled: true
+        threadedDecodingThreshold: 1
+
+        property int integer
+        property string string
+    }
+
+    DBusInterface {
+        id:              lazysrv
+        service:         'org.nemomobile.dbustestd'
+        path:            '/'
+        iface:           'org.nemomobile.dbustestd'
+        lazyRepliesEnabled: true
+
+        property var values: []
+        property int valueCount: values.length
+    }
+
+    DBusInterface {
+        id:              buffersrv
+        service:         'org.nemomobile.dbustestd'
+        path:            '/'
+        iface:           'org.nemomobile.dbustestd'
+        arrayBuffersEnabled: true
+
+        property var bytes: []
+        property int byteCount: bytes.length
+        property var values: []
+        property int valueCount: values.length
+    }
+
     DBusInterface {
         id:              testsrv
         service:         'org.nemomobile.dbustestd'
@@ -0,0 +1,20 @@
+TEMPLATE = lib
+TARGET = tst_coroutine
+
+# Only compiled to check nemo-dbus/coroutine.h, which the library itself doesn't use, nothing
+# is linked or installed.
+CONFIG += staticlib
+
+greaterThan(QT_MAJOR_VERSION, 5): CONFIG += c++20
+else: CONFIG += c++2a
+
+# GCC 10 needs coroutines enabled separately.
+*g++*: QMAKE_CXXFLAGS += -fcoroutines
+
+QT -= gui
+QT += dbus
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+        tst_coroutine.cpp
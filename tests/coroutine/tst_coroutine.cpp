@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#include <nemo-dbus/coroutine.h>
+#include <nemo-dbus/interface.h>
+
+#include <type_traits>
+
+#if !defined(__cpp_impl_coroutine)
+#error "nemo-dbus/coroutine.h can only be checked with C++20 coroutines enabled"
+#endif
+
+// Never run, this only checks that awaiting each shape of reply compiles.
+namespace {
+
+NemoDBus::Task awaitReplies(NemoDBus::Interface *interface)
+{
+    co_await NemoDBus::reply<>(interface->call(QStringLiteral("ping")));
+
+    const auto string = co_await NemoDBus::reply<QString>(
+                interface->call(QStringLiteral("echo"), QStringLiteral("string")));
+    static_assert(std::is_same<decltype(string), const QString>::value,
+                  "a single argument is returned as is");
+
+    const auto values = co_await NemoDBus::reply<QString, int>(
+                interface->call(QStringLiteral("echo"), QStringLiteral("string"), 1));
+    static_assert(std::is_same<decltype(values), const std::tuple<QString, int>>::value,
+                  "several arguments are returned as a tuple");
+
+    try {
+        co_await NemoDBus::reply<>(interface->call(QStringLiteral("fail")));
+    } catch (const NemoDBus::CallError &error) {
+        qWarning("%s", error.what());
+    }
+}
+
+}
+
+void tst_coroutine(NemoDBus::Interface *interface)
+{
+    awaitReplies(interface);
+}
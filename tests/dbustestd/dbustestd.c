@@ -31,6 +31,7 @@
 #define TESTSRV_REQ_ECHO "echo"
 #define TESTSRV_REQ_PING "ping"
 #define TESTSRV_REQ_QUIT "quit"
+#define TESTSRV_REQ_DELAY "delay"
 
 #define TESTSRV_SIG_PONG "pong"
 
@@ -120,6 +121,8 @@ static DBusMessage       *service_handle_repr_req      (DBusMessage *req);
 static DBusMessage       *service_handle_echo_req      (DBusMessage *req);
 static DBusMessage       *service_handle_ping_req      (DBusMessage *req);
 static DBusMessage       *service_handle_quit_req      (DBusMessage *req);
+static gboolean           service_send_delayed_cb      (gpointer aptr);
+static DBusMessage       *service_handle_delay_req     (DBusMessage *req);
 
 static service_handler_t  service_get_handler          (const char *interface, const char *member);
 
@@ -465,6 +468,9 @@ static const char service_xml[] =
 "      <arg direction=\"out\" name=\"args_as_is\" />\n"
 "    </method>\n"
 "    <method name=\""TESTSRV_REQ_QUIT"\"/>\n"
+"    <method name=\""TESTSRV_REQ_DELAY"\">\n"
+"      <arg direction=\"in\" name=\"msec\" type=\"i\" />\n"
+"    </method>\n"
 "    <signal name=\""TESTSRV_SIG_PONG"\">\n"
 "      <arg name=\"args_to_ping_as_is\" />\n"
 "    </signal>\n"
@@ -767,6 +773,47 @@ service_handle_quit_req(DBusMessage *req)
     return rsp;
 }
 
+/* Set by handlers which send their reply later on their own */
+static bool service_reply_deferred = false;
+
+static gboolean
+service_send_delayed_cb(gpointer aptr)
+{
+    DBusMessage *rsp = aptr;
+
+    dbus_connection_send(service_con, rsp, 0);
+    dbus_message_unref(rsp);
+
+    return FALSE;
+}
+
+static DBusMessage *
+service_handle_delay_req(DBusMessage *req)
+{
+    DBusMessage  *rsp  = 0;
+    DBusError     err  = DBUS_ERROR_INIT;
+    dbus_int32_t  msec = 0;
+
+    if( !dbus_message_get_args(req, &err,
+                               DBUS_TYPE_INT32, &msec,
+                               DBUS_TYPE_INVALID) ) {
+        rsp = dbus_message_new_error(req, err.name, err.message);
+        dbus_error_free(&err);
+        goto EXIT;
+    }
+
+    if( !(rsp = dbus_message_new_method_return(req)) )
+        goto EXIT;
+
+    // reply from the mainloop once the delay has passed
+    g_timeout_add(msec > 0 ? msec : 0, service_send_delayed_cb, rsp);
+    service_reply_deferred = true;
+    rsp = 0;
+
+EXIT:
+    return rsp;
+}
+
 static int service_integer_property = 12;
 
 static void
@@ -1008,6 +1055,11 @@ static const service_method_t service_method_lut[] =
     .sm_member    = TESTSRV_REQ_QUIT,
     .sm_handler   = service_handle_quit_req,
   },
+  {
+    .sm_interface = TESTSRV_INTERFACE,
+    .sm_member    = TESTSRV_REQ_DELAY,
+    .sm_handler   = service_handle_delay_req,
+  },
   {
     .sm_interface = "org.freedesktop.DBus.Properties",
     .sm_member    = "Get",
@@ -1076,7 +1128,7 @@ service_filter_cb(DBusConnection *con, DBusMessage *msg, gpointer aptr)
 
     log_emit(LOG_NOTICE, "handle %s.%s()", interface, member);
 
-    if( !(rsp = handler(msg)) )
+    if( !(rsp = handler(msg)) && !service_reply_deferred )
         rsp = dbus_message_new_error(msg, DBUS_ERROR_FAILED, "internal error");
 
     stayalive_renew();
@@ -1088,6 +1140,10 @@ EXIT:
             dbus_connection_send(con, rsp, 0);
         dbus_message_unref(rsp);
     }
+    else if( service_reply_deferred ) {
+        service_reply_deferred = false;
+        res = DBUS_HANDLER_RESULT_HANDLED;
+    }
 
     return res;
 }
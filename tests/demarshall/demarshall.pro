@@ -0,0 +1,15 @@
+TARGET = tst_demarshall
+
+CONFIG += testcase
+
+QT -= gui
+QT += dbus testlib
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+        tst_demarshall.cpp
+
+target.path = /opt/tests/nemo-qml-plugin-dbus-qt5
+
+INSTALLS += target
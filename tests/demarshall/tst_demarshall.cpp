@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its contributors
+ *     may be used to endorse or promote products derived from this
+ *     software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include <nemo-dbus/dbus.h>
+
+#include <QtTest>
+
+using NemoDBus::demarshallArgument;
+
+class tst_Demarshall : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void variant();
+    void variantList();
+    void variantMap();
+};
+
+void tst_Demarshall::variant()
+{
+    // The content of a variant argument is unwrapped, anything else is kept as is.
+    QCOMPARE(demarshallArgument<QVariant>(QVariant::fromValue(QDBusVariant(QVariant(5)))),
+             QVariant(5));
+    QCOMPARE(demarshallArgument<QVariant>(QVariant(QStringLiteral("plain"))),
+             QVariant(QStringLiteral("plain")));
+}
+
+void tst_Demarshall::variantList()
+{
+    // A string array is received as a QStringList.
+    const QStringList strings = { QStringLiteral("foo"), QStringLiteral("bar") };
+    const QVariantList expected = { QStringLiteral("foo"), QStringLiteral("bar") };
+    QCOMPARE(demarshallArgument<QVariantList>(QVariant(strings)), expected);
+
+    // Elements of an array of variants are unwrapped.
+    const QVariantList variants = {
+        QVariant::fromValue(QDBusVariant(QStringLiteral("foo"))),
+        QVariant::fromValue(QDBusVariant(QStringLiteral("bar")))
+    };
+    QCOMPARE(demarshallArgument<QVariantList>(QVariant(variants)), expected);
+}
+
+void tst_Demarshall::variantMap()
+{
+    QVariantMap expected;
+    expected.insert(QStringLiteral("foo"), 1);
+    expected.insert(QStringLiteral("bar"), QStringLiteral("baz"));
+
+    QCOMPARE(demarshallArgument<QVariantMap>(QVariant(expected)), expected);
+
+    QVariantMap variants;
+    variants.insert(QStringLiteral("foo"), QVariant::fromValue(QDBusVariant(1)));
+    variants.insert(QStringLiteral("bar"), QVariant::fromValue(QDBusVariant(QStringLiteral("baz"))));
+
+    QCOMPARE(demarshallArgument<QVariantMap>(QVariant(variants)), expected);
+}
+
+QTEST_APPLESS_MAIN(tst_Demarshall)
+
+#include "tst_demarshall.moc"